@@ -15,6 +15,7 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ***************************************************************************/
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 #include <avr/eeprom.h>
 #include <stdio.h>
 #include "avr/iox32e5.h"
@@ -30,6 +31,9 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "keypad.h"
 #include "chart.h"
 #include "analog.h"
+#include "power.h"
+#include "fft.h"
+#include "filter.h"
 
 #define OFFSET_MID  0
 #define OFFSET_MAX (100)
@@ -38,31 +42,155 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #define GAIN_MIN (GAIN_MID-(100<<1))
 #define GAIN_MAX (GAIN_MID+(100<<1))
 #define RESULT_REFRESH  250 // ms
+#define GLITCH_GAP  32 // TCC5 ticks (8us) between out-of-window results of one event
+#define LEVEL_MAX  8191
+#define LEVEL_MIN (-LEVEL_MAX-1)
+#define SCOPE_TIMEOUT  2 // refresh periods without trigger (auto mode)
+#define SAMPVAL_MAX  63
+#define SLOPE_SHIFT  12 // Q12 segment slopes
+#define STEP_MAX  1000 // reference adjustment step
+#define CONVERSION  7 // ADC clock cycles per conversion (without sampling)
+#define RANGE_RATE  8 // range decisions per second
+#define RANGE_SETTLE  2 // samples held after a range change
+
+typedef enum {
+    ANALOG_SCOPE_OFF,
+    ANALOG_SCOPE_ARMING, // pre-trigger samples
+    ANALOG_SCOPE_ARMED,
+    ANALOG_SCOPE_TRIGGERED, // post-trigger samples
+    ANALOG_SCOPE_DONE,
+} ANALOG_SCOPE_STATE_t;
+
+typedef enum {
+    ANALOG_SPECTRUM_CAPTURE,
+    ANALOG_SPECTRUM_WINDOW,
+    ANALOG_SPECTRUM_STAGE,
+    ANALOG_SPECTRUM_MAGNITUDE,
+    ANALOG_SPECTRUM_DONE,
+} ANALOG_SPECTRUM_STATE_t;
+
+typedef enum {
+    ANALOG_GLITCH_OFF,
+    ANALOG_GLITCH_ABOVE,
+    ANALOG_GLITCH_BELOW,
+} ANALOG_GLITCH_t;
 
 static ANALOG_SETTINGS_t* ANALOG_settings;
 static struct ANALOG_struct {
     volatile uint8_t update;
     uint8_t hold;
+    uint8_t page; // settings page (ADC, filter)
+    uint8_t bits; // result resolution of the mode
     int16_t trigger, value, max, min, last;
     uint16_t count;
     int32_t total;
+    struct {
+        ANALOG_GLITCH_t mode;
+        volatile uint16_t period; // refresh periods (TCC5 overflows)
+        volatile uint16_t count;
+        volatile int16_t peak;
+        volatile uint32_t time, last;
+        uint16_t shown;
+    } glitch;
+    struct {
+        ANALOG_SCOPE_STATE_t state;
+        uint8_t low, high; // signal was below/above level (hysteresis)
+        uint8_t timeout;
+        uint16_t count;
+        uint16_t trigger; // BUFFER index of the trigger sample
+    } scope;
+    struct {
+        ANALOG_SPECTRUM_STATE_t state;
+        uint8_t stage;
+        uint8_t amplitude; // readout of the peak amplitude instead of frequency
+        uint16_t peak, bin;
+    } spectrum;
+    struct {
+        uint16_t count;
+        int16_t max, min;
+        int32_t sum;
+        uint64_t squares;
+        int16_t result[ANALOG_STAT_CREST+1];
+    } stats;
+    struct {
+        ANALOG_RANGE_t base; // range of the mode, samples are normalized to it
+        ANALOG_RANGE_t adc; // range of the conversions
+        ANALOG_RANGE_t read; // range of the samples read from BUFFER
+        uint16_t index; // BUFFER index of the first conversion of adc range
+        uint8_t settle;
+        uint16_t period, count;
+        int16_t peak, last;
+    } range;
+    struct {
+        uint8_t page, point;
+        uint16_t step;
+        int16_t sample;
+    } calibration;
+    struct {
+        uint8_t count; // captured points, first in settings.point[]
+        int16_t slope[ANALOG_POINTS];
+    } correction;
     ANALOG_Result_t Result;
+    ANALOG_Interrupt_t Interrupt;
     ANALOG_SETTINGS_t settings;
 } ANALOG;
 
 static void ANALOG_Loop(void);
 static void ANALOG_Flush(void);
 static void ANALOG_KeyUp(KEYPAD_KEY_t key);
+static void ANALOG_Zoom(KEYPAD_KEY_t key);
 static void ANALOG_Hold(void);
 static inline void ANALOG_ChangeCount(void);
+static void ANALOG_Setup(void);
+static void ANALOG_Settings(void);
+static void ANALOG_SettingsLoop(void);
+static void ANALOG_SettingsKeyUp(KEYPAD_KEY_t key);
+static void ANALOG_FilterLoop(void);
+static void ANALOG_FilterKeyUp(KEYPAD_KEY_t key);
+static inline void ANALOG_Stats(int16_t sample);
+static void ANALOG_StatsResult(void);
+static void ANALOG_StatsClear(void);
+static void ANALOG_StatsPrint(void);
+static uint16_t ANALOG_Sqrt(uint32_t value);
+static void ANALOG_Glitch(void);
+static void ANALOG_GlitchLoop(void);
+static void ANALOG_Scope(void);
+static void ANALOG_ScopeArm(void);
+static void ANALOG_ScopeLoop(void);
+static uint8_t ANALOG_ScopeTrigger(int16_t sample);
+static void ANALOG_ScopeCapture(void);
+static void ANALOG_ScopeKeyUp(KEYPAD_KEY_t key);
+static void ANALOG_ScopeExit(void);
+static void ANALOG_ScopeSettingsLoop(void);
+static void ANALOG_ScopeSettingsKeyUp(KEYPAD_KEY_t key);
+static void ANALOG_Spectrum(void);
+static void ANALOG_SpectrumCapture(void);
+static void ANALOG_SpectrumLoop(void);
+static void ANALOG_SpectrumColumns(void);
+static void ANALOG_SpectrumKeyUp(KEYPAD_KEY_t key);
+static inline int16_t ANALOG_RangeSample(void);
+static void ANALOG_RangeSet(ANALOG_RANGE_t range);
+static void ANALOG_RangeReset(void);
+static inline int16_t ANALOG_RangeNormalize(int16_t sample, ANALOG_RANGE_t range);
+static int16_t* ANALOG_Offset(ANALOG_RANGE_t range);
+static uint16_t* ANALOG_Gain(ANALOG_RANGE_t range);
 static inline void ANALOG_CalibrationSetup(void);
+static void ANALOG_PointsSort(void);
+static void ANALOG_CorrectionSetup(void);
+static int16_t ANALOG_Correct(int16_t value);
+static void ANALOG_Print(int16_t value);
+static void ANALOG_PrintDelta(int16_t base, int16_t delta);
 static void ANALOG_CalibrationKeyUp(KEYPAD_KEY_t key);
 static void ANALOG_CalibrationUpdate(void);
 static inline void ANALOG_SaveSettings(void);
 static inline void ANALOG_LoadSettings(void);
 
-void ANALOG_Init(ANALOG_SETTINGS_t* settings) {
+void ANALOG_Init(ANALOG_SETTINGS_t* settings, uint8_t bits) {
     ANALOG_settings = settings;
+    ANALOG.bits = bits;
+    uint8_t gain = (ADCA.CH0.CTRL&ADC_CH_GAIN_gm)>>ADC_CH_GAIN_gp; // set by the mode
+    ANALOG.range.base = (gain==(ADC_CH_GAIN_DIV2_gc>>ADC_CH_GAIN_gp)) ? ANALOG_RANGE_DIV2 : (ANALOG_RANGE_1X+gain);
+    ANALOG.range.adc = ANALOG.range.base;
     ANALOG_LoadSettings();
     CHART_Init();
     DISPLAY_Mode(DISPLAY_MODE_RAW);
@@ -85,18 +213,22 @@ void ANALOG_Init(ANALOG_SETTINGS_t* settings) {
     TCC5.PER = (RESULT_REFRESH*125)-1;
     TCC5.CTRLA = TC45_CLKSEL_DIV256_gc;
     ANALOG_CalibrationSetup();
+    ANALOG_CorrectionSetup();
     ADCA.CH0.INTCTRL = ADC_CH_INTMODE_COMPLETE_gc|ADC_CH_INTLVL_OFF_gc;
     ADCA.REFCTRL = ADC_REFSEL_AREFA_gc;
     ADCA.CTRLB = ADC_CURRLIMIT_NO_gc|ADC_CONMODE_bm|ADC_FREERUN_bm|ADC_RESOLUTION_MT12BIT_gc;
-    ADCA.PRESCALER = ADC_PRESCALER_DIV32_gc;
-    ADCA.SAMPCTRL = (1<<ADC_SAMPVAL_gp)&ADC_SAMPVAL_gm;
+    ANALOG_Setup();
     ADCA.CALL = DEVICE_ReadCalibrationByte(offsetof(NVM_PROD_SIGNATURES_t, ADCACAL0));
     ADCA.CALH = DEVICE_ReadCalibrationByte(offsetof(NVM_PROD_SIGNATURES_t, ADCACAL1));
     ADCA.CTRLA = ADC_FLUSH_bm|ADC_ENABLE_bm;
     BUFFER_Init(BUFFER_MODE_ADCA_RES);
+    ANALOG_RangeReset();
     ANALOG.Result = NULL;
+    ANALOG.Interrupt = NULL;
     ANALOG.update = 0;
     ANALOG.hold = 0;
+    ANALOG.glitch.mode = ANALOG_GLITCH_OFF;
+    ANALOG.scope.state = ANALOG_SCOPE_OFF;
 }
 
 static void ANALOG_Flush(void) {
@@ -105,6 +237,8 @@ static void ANALOG_Flush(void) {
         ANALOG.value = 0;
         ANALOG.min = 0;
         ANALOG_ChangeCount();
+        ANALOG_StatsClear();
+        FILTER_Reset();
         MAIN_Loop(ANALOG_Loop);
     }
 }
@@ -112,10 +246,12 @@ static void ANALOG_Flush(void) {
 static void ANALOG_Loop(void) {
     static int16_t avg;
     while(!BUFFER_Empty()) {
-        int16_t sample = BUFFER_GetSample();
+        int16_t sample = ANALOG_RangeSample();
+        if(ANALOG.settings.filter) { sample = FILTER_Sample(sample); }
         if(sample>ANALOG.max) { ANALOG.max = sample; }
         if(sample<ANALOG.min) { ANALOG.min = sample; }
         ANALOG.total += sample;
+        ANALOG_Stats(sample);
         if(CHART_Sample()) {
             avg = ANALOG.total/ANALOG.count;
             CHART_Value(ANALOG.max, avg, ANALOG.min);
@@ -132,10 +268,11 @@ static void ANALOG_Loop(void) {
                 int16_t max = CHART_Max();
                 int16_t min = CHART_Min();
                 int16_t dif = max-min;
-                if(dif>=((max/CHART_FULL_SCALE)+4)) {
+                const uint8_t shift = ANALOG.range.adc-ANALOG.range.base;
+                if((dif>=((max/CHART_FULL_SCALE)+4))&&(ANALOG.range.read==ANALOG.range.adc)) {
                     EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
-                    ADCA_CMP = min+(dif/4);
-                    ANALOG.trigger = min+(dif/2);
+                    ADCA_CMP = (min+(dif/4))<<shift; // compared with conversions
+                    ANALOG.trigger = (min+(dif/2))<<shift;
                     ADCA_CH0_INTCTRL = ADC_CH_INTMODE_BELOW_gc|ADC_CH_INTLVL_LO_gc;
                     if(!ANALOG.hold) {
                         EVSYS_STROBE = EVSYS_CHMUX4_bm;
@@ -152,7 +289,11 @@ static void ANALOG_Loop(void) {
     if(DISPLAY_Update()){
         CHART_Update();
         DISPLAY_CursorPosition(8,1);
-        if(ANALOG.Result) { ANALOG.Result(ANALOG.value); }
+        ANALOG_StatsPrint();
+        if(ANALOG.range.read!=ANALOG.range.base) {
+            DISPLAY_CursorPosition(1,1);
+            printf_P(TEXT_ADC_RANGE_MARK, ANALOG.range.read-ANALOG.range.base);
+        }
         if(ANALOG.hold) { DISPLAY_InvertLine(0); }
         if(ANALOG.settings.speed<=CHART_SPEED_4) {
             CHART_Marker();
@@ -160,13 +301,201 @@ static void ANALOG_Loop(void) {
     }
 }
 
+/* Samples converted after a range change start at the BUFFER index stored
+ * by ANALOG_RangeSet (it may be skipped over when BUFFER is cleared) */
+static inline int16_t ANALOG_RangeSample(void) {
+    if(ANALOG.range.read!=ANALOG.range.adc) {
+        uint16_t index = (ANALOG.range.index-BUFFER.first)&BUFFER_MAX;
+        if((!index)||(index>((uint16_t)((BUFFER.last-BUFFER.first)&BUFFER_MAX)))) {
+            ANALOG.range.read = ANALOG.range.adc;
+            ANALOG.range.settle = RANGE_SETTLE;
+        }
+    }
+    int16_t sample = BUFFER_GetSample();
+    if(ANALOG.range.settle) {
+        ANALOG.range.settle--;
+        return ANALOG.range.last;
+    }
+    if(ANALOG.range.read==ANALOG.range.adc) {
+        /* Gain is lowered at once near the full scale of the conversion,
+         * raised when the peak of a whole period fits in a quarter of it */
+        const int16_t full = 1<<(ANALOG.bits-1);
+        const int16_t level = (sample<0) ? -sample : sample;
+        if(level>(full-(full/8))) {
+            if(ANALOG.range.adc>ANALOG.range.base) {
+                ANALOG_RangeSet(ANALOG.range.adc-1);
+            }
+        } else {
+            if(level>ANALOG.range.peak) { ANALOG.range.peak = level; }
+            if(!(--ANALOG.range.count)) {
+                if((ANALOG.range.peak<(full/4))&&(ANALOG.range.adc<ANALOG_RANGE_64X)) {
+                    ANALOG_RangeSet(ANALOG.range.adc+1);
+                } else {
+                    ANALOG.range.count = ANALOG.range.period;
+                    ANALOG.range.peak = 0;
+                }
+            }
+        }
+    }
+    ANALOG.range.last = ANALOG_RangeNormalize(sample, ANALOG.range.read);
+    return ANALOG.range.last;
+}
+
+/* New gain and its own calibration, conversions in progress are flushed */
+static void ANALOG_RangeSet(ANALOG_RANGE_t range) {
+    uint8_t gain = (range==ANALOG_RANGE_DIV2) ? ADC_CH_GAIN_DIV2_gc : ((range-ANALOG_RANGE_1X)<<ADC_CH_GAIN_gp);
+    ADCA.CH0.CTRL = (ADCA.CH0.CTRL&~ADC_CH_GAIN_gm)|gain;
+    ANALOG.range.adc = range;
+    ANALOG_CalibrationSetup();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ADCA.CTRLA |= ADC_FLUSH_bm;
+        BUFFER_Empty(); // update BUFFER.last
+        ANALOG.range.index = BUFFER.last;
+    }
+    ANALOG.range.count = ANALOG.range.period;
+    ANALOG.range.peak = 0;
+}
+
+/* Views other than the chart compare conversions with levels directly,
+ * the samples read after them do not continue the filtered ones */
+static void ANALOG_RangeReset(void) {
+    FILTER_Reset();
+    ANALOG_RangeSet(ANALOG.range.base);
+    ANALOG.range.read = ANALOG.range.base;
+    ANALOG.range.settle = 0;
+    ANALOG.range.last = 0;
+}
+
+static inline int16_t ANALOG_RangeNormalize(int16_t sample, ANALOG_RANGE_t range) {
+    const uint8_t shift = range-ANALOG.range.base;
+    if(!shift) { return sample; }
+    return (sample+(1<<(shift-1)))>>shift; // rounded
+}
+
+static int16_t* ANALOG_Offset(ANALOG_RANGE_t range) {
+    if(range==ANALOG.range.base) { return &ANALOG.settings.offset; }
+    return &ANALOG.settings.range[range].offset;
+}
+
+static uint16_t* ANALOG_Gain(ANALOG_RANGE_t range) {
+    if(range==ANALOG.range.base) { return &ANALOG.settings.gain; }
+    return &ANALOG.settings.range[range].gain;
+}
+
 static inline void ANALOG_ChangeCount(void) {
     ANALOG.count = CHART_Count(ANALOG.settings.speed);
     ANALOG.total = 0;
 }
 
+/* Averaged result of 2^n conversions is 12+n bits wide and is shifted right
+ * to the resolution of the mode (the minimum averaging keeps the shift >= 0) */
+static void ANALOG_Setup(void) {
+    const uint8_t sampnum = ANALOG.settings.sampnum;
+    ADCA.PRESCALER = (ANALOG.settings.prescaler+ADC_PRESCALER_DIV32_gc)&ADC_PRESCALER_gm;
+    ADCA.SAMPCTRL = (ANALOG.settings.sampval<<ADC_SAMPVAL_gp)&ADC_SAMPVAL_gm;
+    ADCA.CH0.AVGCTRL = ((12+sampnum-ANALOG.bits)<<ADC_CH_RIGHTSHIFT_gp)|(sampnum<<ADC_SAMPNUM_gp);
+    CHART_Rate(((ANALOG_Rate()<<8)+(ANALOG_RATE_NOMINAL/2))/ANALOG_RATE_NOMINAL);
+    ANALOG.range.period = (ANALOG_Rate()/RANGE_RATE)+1;
+    FILTER_Setup(ANALOG.settings.filter, ANALOG.settings.order, ANALOG_Rate());
+}
+
+/* Approximate rate of averaged results, sampling takes SAMPVAL+1 cycles */
+uint32_t ANALOG_Rate(void) {
+    uint32_t clock = F_CPU>>(ANALOG.settings.prescaler+5);
+    uint16_t cycles = (CONVERSION+ANALOG.settings.sampval+1)<<ANALOG.settings.sampnum;
+    return clock/cycles;
+}
+
+/* Running statistics over a window of 2^n samples, the sum of squares needs
+ * 64 bits (14-bit samples, 16K window) but only additions are done here */
+static inline void ANALOG_Stats(int16_t sample) {
+    if(sample>ANALOG.stats.max) { ANALOG.stats.max = sample; }
+    if(sample<ANALOG.stats.min) { ANALOG.stats.min = sample; }
+    ANALOG.stats.sum += sample;
+    ANALOG.stats.squares += (uint32_t)((int32_t)sample*sample);
+    if(!(--ANALOG.stats.count)) {
+        ANALOG_StatsResult();
+    }
+}
+
+static void ANALOG_StatsResult(void) {
+    const uint8_t shift = 8+(ANALOG.settings.window*2);
+    const int32_t sum = ANALOG.stats.sum;
+    const uint64_t squares = ANALOG.stats.squares;
+    int16_t* result = ANALOG.stats.result;
+    result[ANALOG_STAT_MEAN] = (sum+((int32_t)1<<(shift-1)))>>shift;
+    const uint16_t rms = ANALOG_Sqrt(squares>>shift);
+    result[ANALOG_STAT_RMS] = rms;
+    /* Integer sums are exact, so sum(x^2)-sum(x)^2/n does not lose precision */
+    int64_t variance = squares-(((int64_t)sum*sum)>>shift);
+    if(variance<0) { variance = 0; }
+    result[ANALOG_STAT_STD] = ANALOG_Sqrt(variance>>shift);
+    int16_t max = ANALOG.stats.max;
+    int16_t min = ANALOG.stats.min;
+    result[ANALOG_STAT_PP] = max-min;
+    if(min<0) { min = -min; }
+    if(min>max) { max = min; }
+    int32_t crest = 0;
+    if(rms) {
+        crest = (((int32_t)max*100)+(rms/2))/rms;
+        if(crest>9999) { crest = 9999; }
+    }
+    result[ANALOG_STAT_CREST] = crest;
+    ANALOG_StatsClear();
+}
+
+static void ANALOG_StatsClear(void) {
+    ANALOG.stats.count = (uint16_t)1<<(8+(ANALOG.settings.window*2));
+    ANALOG.stats.max = INT16_MIN;
+    ANALOG.stats.min = INT16_MAX;
+    ANALOG.stats.sum = 0;
+    ANALOG.stats.squares = 0;
+}
+
+static void ANALOG_StatsPrint(void) {
+    static const __flash char* const __flash LABEL[] = {
+        [ANALOG_STAT_MEAN] = TEXT_STAT_MEAN,
+        [ANALOG_STAT_RMS] = TEXT_STAT_RMS,
+        [ANALOG_STAT_STD] = TEXT_STAT_STD,
+        [ANALOG_STAT_PP] = TEXT_STAT_PP,
+        [ANALOG_STAT_CREST] = TEXT_STAT_CREST,
+    };
+    const ANALOG_STAT_t stat = ANALOG.settings.stat;
+    if(stat==ANALOG_STAT_CREST) {
+        const uint16_t crest = ANALOG.stats.result[ANALOG_STAT_CREST];
+        printf_P(TEXT_ADC_CREST, crest/100, crest%100);
+    } else if((stat==ANALOG_STAT_STD)||(stat==ANALOG_STAT_PP)) {
+        ANALOG_PrintDelta(ANALOG.stats.result[ANALOG_STAT_MEAN], ANALOG.stats.result[stat]);
+    } else {
+        ANALOG_Print(stat ? ANALOG.stats.result[stat] : ANALOG.value);
+    }
+    if(stat) {
+        DISPLAY_CursorPosition(55, 1); // instead of chart scale
+        puts_P(LABEL[stat]);
+    }
+}
+
+static uint16_t ANALOG_Sqrt(uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = (uint32_t)1<<30;
+    while(bit>value) { bit >>= 2; }
+    while(bit) {
+        if(value>=(root+bit)) {
+            value -= root+bit;
+            root = (root>>1)+bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
 static void ANALOG_KeyUp(KEYPAD_KEY_t key) {
-    if(ANALOG.hold && key!=KEYPAD_KEY3) { return; }
+    if(ANALOG.hold && key!=KEYPAD_KEY3) {
+        ANALOG_Zoom(key);
+        return;
+    }
     switch(key) {
     case KEYPAD_KEY1:
         if(ANALOG.settings.speed>CHART_SPEED_1) {
@@ -186,35 +515,719 @@ static void ANALOG_KeyUp(KEYPAD_KEY_t key) {
         ANALOG_Hold();
         break;
     case KEYPAD_KEY4:
+        if((ANALOG.settings.stat++)==ANALOG_STAT_CREST) {
+            ANALOG.settings.stat = ANALOG_STAT_VALUE;
+        }
+        ANALOG_SaveSettings();
+        break;
+    case KEYPAD_KEY12:
+        if((ANALOG.settings.window++)==ANALOG_WINDOW_16K) {
+            ANALOG.settings.window = ANALOG_WINDOW_256;
+        }
+        ANALOG_StatsClear();
+        ANALOG_SaveSettings();
+        break;
+    case KEYPAD_KEY34:
         CHART_Lock();
         break;
+    case KEYPAD_KEY23:
+        ANALOG_Glitch();
+        break;
+    case KEYPAD_KEY14:
+        ANALOG_Scope();
+        break;
+    case KEYPAD_KEY13:
+        ANALOG_Settings();
+        break;
+    case KEYPAD_KEY24:
+        POWER_Init();
+        break;
     default:
         break;
     }
 }
 
+/* Held chart is shown at another speed from the levels CHART keeps */
+static void ANALOG_Zoom(KEYPAD_KEY_t key) {
+    CHART_SPEED_t speed = ANALOG.settings.speed;
+    if((key==KEYPAD_KEY1)&&(speed>CHART_SPEED_1)) {
+        speed--;
+    } else if((key==KEYPAD_KEY2)&&(speed<CHART_SPEED_10)) {
+        speed++;
+    } else {
+        return;
+    }
+    if(CHART_Zoom(speed)) {
+        ANALOG.settings.speed = speed;
+        ANALOG_SaveSettings();
+    }
+}
+
 static void ANALOG_Hold(void) {
     ANALOG.hold = !ANALOG.hold;
     if(ANALOG.hold) {
         EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
         DISPLAY_Backlight(DISPLAY_BACKLIGHT_AUX);
     } else {
-        EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+        if(!ANALOG.glitch.mode) {
+            EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+        }
         DISPLAY_Backlight(DISPLAY_BACKLIGHT_MAIN);
     }
 }
 
+/* Glitch capture uses ADC channel compare (above the chart maximum or below
+ * the chart minimum). Channel events (EDMA) and interrupts are generated only
+ * for results out of window, so there is no CPU load inside the window. */
+static void ANALOG_Glitch(void) {
+    ADCA_CH0_INTCTRL = ADC_CH_INTMODE_COMPLETE_gc|ADC_CH_INTLVL_OFF_gc;
+    EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
+    ANALOG_RangeReset();
+    if((ANALOG.glitch.mode++)==ANALOG_GLITCH_BELOW) {
+        ANALOG.glitch.mode = ANALOG_GLITCH_OFF;
+        CHART_Clear();
+        ANALOG_ChangeCount();
+        ANALOG_StatsClear();
+        BUFFER_Clear();
+        MAIN_Loop(ANALOG_Loop);
+        if(!ANALOG.hold) {
+            EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+        }
+        return;
+    }
+    int16_t max = CHART_Max();
+    int16_t min = CHART_Min();
+    int16_t margin = ((max-min)/8)+(max/CHART_FULL_SCALE)+4;
+    ANALOG.glitch.count = 0;
+    ANALOG.glitch.shown = 0;
+    ANALOG.glitch.time = 0;
+    ANALOG.glitch.last = -(GLITCH_GAP+1);
+    ANALOG.glitch.peak = 0;
+    ANALOG.glitch.period = 0; // timestamps start here
+    TCC5_CTRLGSET = TC45_CMD_RESTART_gc;
+    CHART_Count(CHART_SPEED_10); // one chart column per event
+    CHART_Clear();
+    MAIN_Loop(ANALOG_GlitchLoop);
+    if(ANALOG.glitch.mode==ANALOG_GLITCH_ABOVE) {
+        ADCA_CMP = max+margin;
+        ADCA_CH0_INTCTRL = ADC_CH_INTMODE_ABOVE_gc|ADC_CH_INTLVL_LO_gc;
+    } else {
+        ADCA_CMP = min-margin;
+        ADCA_CH0_INTCTRL = ADC_CH_INTMODE_BELOW_gc|ADC_CH_INTLVL_LO_gc;
+    }
+}
+
+static void ANALOG_GlitchLoop(void) {
+    uint16_t count;
+    int16_t peak;
+    uint32_t time;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        count = ANALOG.glitch.count;
+        peak = ANALOG.glitch.peak;
+        time = ANALOG.glitch.time;
+    }
+    if(count!=ANALOG.glitch.shown) {
+        ANALOG.glitch.shown = count;
+        CHART_Sample();
+        CHART_Value(peak, peak, peak);
+    }
+    if(DISPLAY_Update()){
+        CHART_Update();
+        DISPLAY_CursorPosition(8,1);
+        ANALOG_Print(peak);
+        DISPLAY_CursorPosition(55, 1); // instead of chart scale
+        printf_P(TEXT_ADC_COUNT, (count>999) ? 999 : count);
+        if(count) {
+            time /= 125; // ms
+            DISPLAY_CursorPosition(2, 10);
+            printf_P(TEXT_ADC_TIME, time/1000, (uint16_t)(time%1000));
+        }
+        if(ANALOG.hold) { DISPLAY_InvertLine(0); }
+        CHART_Marker();
+    }
+}
+
 void ANALOG_Result(ANALOG_Result_t Result) {
     ANALOG.Result = Result;
 }
 
+static void ANALOG_Print(int16_t value) {
+    if(ANALOG.Result) { ANALOG.Result(ANALOG_Correct(value)); }
+}
+
+/* Differences (P-P, STD, amplitude) are corrected around their base */
+static void ANALOG_PrintDelta(int16_t base, int16_t delta) {
+    if(ANALOG.Result) { ANALOG.Result(ANALOG_Correct(base+delta)-ANALOG_Correct(base)); }
+}
+
+void ANALOG_Interrupt(ANALOG_Interrupt_t Interrupt) {
+    ANALOG.Interrupt = Interrupt;
+}
+
+uint8_t ANALOG_Refresh(void) {
+    if(ANALOG.update) {
+        ANALOG.update = 0;
+        return 1;
+    }
+    return 0;
+}
+
+/* Calibration of another mode, validated like in ANALOG_LoadSettings */
+void ANALOG_Correction(ANALOG_SETTINGS_t* settings, int16_t* offset, uint16_t* gain) {
+    *offset = eeprom_read_word((uint16_t*)&settings->offset);
+    if((*offset<OFFSET_MIN)||(*offset>OFFSET_MAX)) { *offset = OFFSET_MID; }
+    *gain = eeprom_read_word(&settings->gain);
+    if((*gain<GAIN_MIN)||(*gain>GAIN_MAX)) { *gain = GAIN_MID; }
+}
+
+static inline uint8_t ANALOG_ScopeSamples(void) {
+    static const __flash uint8_t SAMPLES[] = {
+        [ANALOG_BASE_1] = 1,
+        [ANALOG_BASE_2] = 2,
+        [ANALOG_BASE_3] = 3,
+        [ANALOG_BASE_4] = 4,
+        [ANALOG_BASE_6] = 6,
+        [ANALOG_BASE_8] = 8,
+    };
+    return SAMPLES[ANALOG.settings.scope.base];
+}
+
+static inline uint8_t ANALOG_ScopePre(void) {
+    return ANALOG.settings.scope.pre*(DISPLAY_WIDTH/4); // columns
+}
+
+/* Triggered scope, the BUFFER ring is filled at full ADC rate and stopped
+ * after post-trigger samples, then decimated to chart columns */
+static void ANALOG_Scope(void) {
+    ADCA_CH0_INTCTRL = ADC_CH_INTMODE_COMPLETE_gc|ADC_CH_INTLVL_OFF_gc;
+    ANALOG_RangeReset();
+    ANALOG.glitch.mode = ANALOG_GLITCH_OFF;
+    KEYPAD_KeyUp(ANALOG_ScopeKeyUp);
+    MAIN_Loop(ANALOG_ScopeLoop);
+    CHART_Count(CHART_SPEED_10); // one chart column per call
+    CHART_Clear();
+    ANALOG_ScopeArm();
+}
+
+static void ANALOG_ScopeArm(void) {
+    EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
+    ANALOG.scope.state = ANALOG_SCOPE_ARMING;
+    ANALOG.scope.low = 0;
+    ANALOG.scope.high = 0;
+    ANALOG.scope.timeout = 0;
+    ANALOG.scope.count = ANALOG_ScopePre()*ANALOG_ScopeSamples();
+    ANALOG.update = 0;
+    BUFFER_Clear();
+    EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+}
+
+static void ANALOG_ScopeLoop(void) {
+    const ANALOG_SCOPE_t* scope = &ANALOG.settings.scope;
+    while((ANALOG.scope.state<ANALOG_SCOPE_TRIGGERED)&&!BUFFER_Empty()) {
+        int16_t sample = BUFFER_GetSample();
+        uint8_t trigger = ANALOG_ScopeTrigger(sample);
+        if(ANALOG.scope.state==ANALOG_SCOPE_ARMING) {
+            if(!ANALOG.scope.count) {
+                ANALOG.scope.state = ANALOG_SCOPE_ARMED;
+            } else {
+                ANALOG.scope.count--;
+            }
+        } else if(trigger) {
+            ANALOG.scope.state = ANALOG_SCOPE_TRIGGERED;
+            ANALOG.scope.trigger = (BUFFER.first-sizeof(int16_t))&BUFFER_MAX;
+        }
+    }
+    if(ANALOG.update) {
+        ANALOG.update = 0;
+        if((ANALOG.scope.state==ANALOG_SCOPE_ARMED)&&(scope->trigger==ANALOG_TRIGGER_AUTO)) {
+            if(++ANALOG.scope.timeout>=SCOPE_TIMEOUT) {
+                ANALOG.scope.state = ANALOG_SCOPE_TRIGGERED; // free running
+                ANALOG.scope.trigger = (BUFFER.first-sizeof(int16_t))&BUFFER_MAX;
+            }
+        }
+    }
+    if(ANALOG.scope.state==ANALOG_SCOPE_TRIGGERED) {
+        BUFFER_Empty(); // update BUFFER.last
+        uint16_t post = (DISPLAY_WIDTH-ANALOG_ScopePre())*ANALOG_ScopeSamples();
+        if((uint16_t)((BUFFER.last-ANALOG.scope.trigger)&BUFFER_MAX)>=(post*sizeof(int16_t))) {
+            EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
+            ANALOG.scope.state = ANALOG_SCOPE_DONE;
+            ANALOG_ScopeCapture();
+        }
+    }
+    if(!DISPLAY_Update()) { return; }
+    CHART_Update();
+    DISPLAY_ClearBar(ANALOG_ScopePre()); // trigger position
+    DISPLAY_CursorPosition(1,1);
+    if(scope->edge==ANALOG_EDGE_RISING) {
+        DISPLAY_PrintChar('/');
+    } else if(scope->edge==ANALOG_EDGE_FALLING) {
+        DISPLAY_PrintChar('\\');
+    } else {
+        DISPLAY_PrintChar('X');
+    }
+    DISPLAY_CursorPosition(8,1);
+    ANALOG_Print(scope->level);
+    DISPLAY_CursorPosition(55, 1); // instead of chart scale
+    if(scope->trigger==ANALOG_TRIGGER_AUTO) {
+        puts_P(TEXT_SCOPE_AUTO);
+    } else if(scope->trigger==ANALOG_TRIGGER_NORMAL) {
+        puts_P(TEXT_SCOPE_NORMAL);
+    } else {
+        puts_P(TEXT_SCOPE_SINGLE);
+    }
+    if(ANALOG.scope.state==ANALOG_SCOPE_DONE) {
+        if(scope->trigger==ANALOG_TRIGGER_SINGLE) {
+            DISPLAY_InvertLine(0);
+        } else {
+            ANALOG_ScopeArm(); // next capture, chart keeps the last one
+        }
+    }
+}
+
+static uint8_t ANALOG_ScopeTrigger(int16_t sample) {
+    const int16_t level = ANALOG.settings.scope.level;
+    const int16_t hysteresis = CHART_Scale();
+    const ANALOG_EDGE_t edge = ANALOG.settings.scope.edge;
+    uint8_t trigger = 0;
+    if(edge!=ANALOG_EDGE_FALLING) {
+        if(sample<(level-hysteresis)) {
+            ANALOG.scope.low = 1;
+        } else if(ANALOG.scope.low&&(sample>=level)) {
+            ANALOG.scope.low = 0;
+            trigger = 1;
+        }
+    }
+    if(edge!=ANALOG_EDGE_RISING) {
+        if(sample>(level+hysteresis)) {
+            ANALOG.scope.high = 1;
+        } else if(ANALOG.scope.high&&(sample<=level)) {
+            ANALOG.scope.high = 0;
+            trigger = 1;
+        }
+    }
+    return trigger;
+}
+
+static void ANALOG_ScopeCapture(void) {
+    const uint8_t samples = ANALOG_ScopeSamples();
+    uint16_t index = ANALOG.scope.trigger-(ANALOG_ScopePre()*samples*sizeof(int16_t));
+    CHART_Clear();
+    for(uint8_t column=0; column<DISPLAY_WIDTH; column++) {
+        int16_t max = INT16_MIN;
+        int16_t min = INT16_MAX;
+        int32_t total = 0;
+        for(uint8_t i=0; i<samples; i++) {
+            index &= BUFFER_MAX;
+            int16_t sample = BUFFER.sample[index/sizeof(int16_t)];
+            index += sizeof(int16_t);
+            if(sample>max) { max = sample; }
+            if(sample<min) { min = sample; }
+            total += sample;
+        }
+        CHART_Sample();
+        CHART_Value(max, total/samples, min);
+    }
+}
+
+static void ANALOG_ScopeKeyUp(KEYPAD_KEY_t key) {
+    ANALOG_SCOPE_t* scope = &ANALOG.settings.scope;
+    int16_t step = CHART_Scale()*2;
+    switch(key) {
+    case KEYPAD_KEY1:
+        scope->level = (scope->level>(LEVEL_MIN+step)) ? (scope->level-step) : LEVEL_MIN;
+        break;
+    case KEYPAD_KEY2:
+        scope->level = (scope->level<(LEVEL_MAX-step)) ? (scope->level+step) : LEVEL_MAX;
+        break;
+    case KEYPAD_KEY3:
+        if((scope->trigger!=ANALOG_TRIGGER_SINGLE)||(ANALOG.scope.state!=ANALOG_SCOPE_DONE)) {
+            if((scope->trigger++)==ANALOG_TRIGGER_SINGLE) {
+                scope->trigger = ANALOG_TRIGGER_AUTO;
+            }
+        }
+        ANALOG_ScopeArm(); // single capture is armed again
+        break;
+    case KEYPAD_KEY4:
+        EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
+        KEYPAD_KeyUp(ANALOG_ScopeSettingsKeyUp);
+        MAIN_Loop(ANALOG_ScopeSettingsLoop);
+        DISPLAY_Select(-1);
+        return;
+    case KEYPAD_KEY14:
+        ANALOG_ScopeExit();
+        return;
+    case KEYPAD_KEY12:
+        ANALOG_Spectrum();
+        return;
+    default:
+        return;
+    }
+    ANALOG_SaveSettings();
+}
+
+static void ANALOG_ScopeExit(void) {
+    ANALOG.scope.state = ANALOG_SCOPE_OFF;
+    CHART_Clear();
+    ANALOG_ChangeCount();
+    ANALOG_StatsClear();
+    KEYPAD_KeyUp(ANALOG_KeyUp);
+    MAIN_Loop(ANALOG_Loop);
+    BUFFER_Clear();
+    EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+}
+
+static void ANALOG_ScopeSettingsLoop(void) {
+    const ANALOG_SCOPE_t* scope = &ANALOG.settings.scope;
+    if(!DISPLAY_Update()) { return; }
+    DISPLAY_CursorPosition(0, 1);
+    puts_P(TEXT_SCOPE_SETTINGS);
+    DISPLAY_CursorPosition(6,15);
+    puts_P(TEXT_SCOPE_EDGE);
+    DISPLAY_MoveCursor(6);
+    if(scope->edge==ANALOG_EDGE_RISING) {
+        puts_P(TEXT_RISING_EDGE);
+    } else if(scope->edge==ANALOG_EDGE_FALLING) {
+        puts_P(TEXT_FALLING_EDGE);
+    } else {
+        puts_P(TEXT_SCOPE_BOTH);
+    }
+    DISPLAY_CursorPosition(6,24);
+    printf_P(TEXT_SCOPE_PRE, scope->pre*25);
+    DISPLAY_CursorPosition(6,33);
+    printf_P(TEXT_SCOPE_BASE, ANALOG_ScopeSamples());
+    DISPLAY_InvertLine(0);
+    DISPLAY_SelectLine();
+}
+
+static void ANALOG_ScopeSettingsKeyUp(KEYPAD_KEY_t key) {
+    ANALOG_SCOPE_t* scope = &ANALOG.settings.scope;
+    switch(key) {
+    case KEYPAD_KEY1:
+        if((scope->edge++)==ANALOG_EDGE_BOTH) {
+            scope->edge = ANALOG_EDGE_RISING;
+        }
+        DISPLAY_Select(14);
+        break;
+    case KEYPAD_KEY2:
+        if((scope->pre++)==ANALOG_PRE_75) {
+            scope->pre = ANALOG_PRE_0;
+        }
+        DISPLAY_Select(23);
+        break;
+    case KEYPAD_KEY3:
+        if((scope->base++)==ANALOG_BASE_8) {
+            scope->base = ANALOG_BASE_1;
+        }
+        DISPLAY_Select(32);
+        break;
+    case KEYPAD_KEY4:
+        ANALOG_SaveSettings();
+        KEYPAD_KeyUp(ANALOG_ScopeKeyUp);
+        MAIN_Loop(ANALOG_ScopeLoop);
+        CHART_Clear();
+        ANALOG_ScopeArm();
+        break;
+    default:
+        break;
+    }
+}
+
+static inline uint16_t ANALOG_SpectrumSize(void) {
+    return (uint16_t)256<<ANALOG.settings.fft;
+}
+
+static void ANALOG_Spectrum(void) {
+    ANALOG.scope.state = ANALOG_SCOPE_OFF;
+    ANALOG.hold = 0;
+    KEYPAD_KeyUp(ANALOG_SpectrumKeyUp);
+    MAIN_Loop(ANALOG_SpectrumLoop);
+    CHART_Clear();
+    ANALOG_SpectrumCapture();
+}
+
+/* EDMA is restarted from the beginning of BUFFER, the samples are then
+ * transformed in place (512 complex points fill whole BUFFER) */
+static void ANALOG_SpectrumCapture(void) {
+    EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
+    BUFFER_Init(BUFFER_MODE_ADCA_RES);
+    ANALOG.spectrum.state = ANALOG_SPECTRUM_CAPTURE;
+    EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+}
+
+/* Only one step (window, one FFT stage, magnitudes) is done per call, so
+ * the display and keypad are still served while the spectrum is computed */
+static void ANALOG_SpectrumLoop(void) {
+    const uint16_t size = ANALOG_SpectrumSize();
+    switch(ANALOG.spectrum.state) {
+    case ANALOG_SPECTRUM_CAPTURE:
+        BUFFER_Empty(); // update BUFFER.last
+        if(BUFFER.last>=(size*sizeof(int16_t))) {
+            EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
+            ANALOG.spectrum.state = ANALOG_SPECTRUM_WINDOW;
+        }
+        break;
+    case ANALOG_SPECTRUM_WINDOW:
+        FFT_Window(BUFFER.sample, size);
+        FFT_Reverse(BUFFER.sample, size);
+        ANALOG.spectrum.stage = 0;
+        ANALOG.spectrum.state = ANALOG_SPECTRUM_STAGE;
+        break;
+    case ANALOG_SPECTRUM_STAGE:
+        FFT_Stage(BUFFER.sample, size, ANALOG.spectrum.stage);
+        if(((uint16_t)2<<ANALOG.spectrum.stage)>=size) {
+            ANALOG.spectrum.state = ANALOG_SPECTRUM_MAGNITUDE;
+        }
+        ANALOG.spectrum.stage++;
+        break;
+    case ANALOG_SPECTRUM_MAGNITUDE:
+        ANALOG_SpectrumColumns();
+        ANALOG.spectrum.state = ANALOG_SPECTRUM_DONE;
+        break;
+    default:
+        if(ANALOG.update) {
+            ANALOG.update = 0;
+            if(!ANALOG.hold) { ANALOG_SpectrumCapture(); }
+        }
+        break;
+    }
+    if(!DISPLAY_Update()) { return; }
+    CHART_Update();
+    DISPLAY_CursorPosition(8,1);
+    if(!ANALOG.spectrum.amplitude) {
+        printf_P(TEXT_FFT_FREQUENCY, (ANALOG.spectrum.bin*ANALOG_Rate())/size);
+    } else {
+        /* Hann window gain is 1/2 and one side of the spectrum has half of
+         * the amplitude, the FFT is already scaled by 1/size */
+        uint32_t amplitude = (uint32_t)ANALOG.spectrum.peak*4;
+        if(amplitude>LEVEL_MAX) { amplitude = LEVEL_MAX; }
+        ANALOG_PrintDelta(0, amplitude);
+    }
+    if(ANALOG.hold) { DISPLAY_InvertLine(0); }
+}
+
+/* Bins 1..size/2-1 (without DC) are spread over the chart columns, every
+ * column shows the highest magnitude of its bins */
+static void ANALOG_SpectrumColumns(void) {
+    const uint16_t bins = (ANALOG_SpectrumSize()/2)-1;
+    uint16_t bin = 1;
+    ANALOG.spectrum.peak = 0;
+    ANALOG.spectrum.bin = 0;
+    CHART_Clear();
+    for(uint8_t column=0; column<DISPLAY_WIDTH; column++) {
+        const uint16_t end = 1+(((column+1)*bins)/DISPLAY_WIDTH);
+        uint16_t max = 0;
+        do {
+            const uint16_t magnitude = FFT_Magnitude(BUFFER.sample, bin);
+            if(magnitude>max) { max = magnitude; }
+            if(magnitude>ANALOG.spectrum.peak) {
+                ANALOG.spectrum.peak = magnitude;
+                ANALOG.spectrum.bin = bin;
+            }
+        } while(++bin<end);
+        CHART_Sample();
+        CHART_Value(max, max, 0);
+    }
+}
+
+static void ANALOG_SpectrumKeyUp(KEYPAD_KEY_t key) {
+    if(ANALOG.hold && key!=KEYPAD_KEY3) { return; }
+    switch(key) {
+    case KEYPAD_KEY1:
+        if((ANALOG.settings.fft++)==ANALOG_FFT_512) {
+            ANALOG.settings.fft = ANALOG_FFT_256;
+        }
+        ANALOG_SaveSettings();
+        ANALOG_SpectrumCapture();
+        break;
+    case KEYPAD_KEY3:
+        ANALOG.hold = !ANALOG.hold;
+        break;
+    case KEYPAD_KEY4:
+        ANALOG.spectrum.amplitude = !ANALOG.spectrum.amplitude;
+        break;
+    case KEYPAD_KEY34:
+        CHART_Lock();
+        break;
+    case KEYPAD_KEY12:
+        ANALOG_Scope();
+        break;
+    case KEYPAD_KEY14:
+        ANALOG_ScopeExit();
+        break;
+    default:
+        break;
+    }
+}
+
+static void ANALOG_Settings(void) {
+    EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
+    ANALOG.page = 0;
+    KEYPAD_KeyUp(ANALOG_SettingsKeyUp);
+    MAIN_Loop(ANALOG_SettingsLoop);
+    DISPLAY_Select(-1);
+}
+
+static void ANALOG_SettingsLoop(void) {
+    if(!DISPLAY_Update()) { return; }
+    if(ANALOG.page) {
+        ANALOG_FilterLoop();
+        return;
+    }
+    DISPLAY_CursorPosition(0, 1);
+    puts_P(TEXT_ADC_SETTINGS);
+    DISPLAY_CursorPosition(6,15);
+    printf_P(TEXT_ADC_PRESCALER, 32<<ANALOG.settings.prescaler);
+    DISPLAY_CursorPosition(6,24);
+    printf_P(TEXT_ADC_SAMPNUM, 1<<ANALOG.settings.sampnum);
+    DISPLAY_CursorPosition(6,33);
+    printf_P(TEXT_ADC_SAMPLING, ANALOG.settings.sampval+1);
+    /* Averaging 2^n samples adds n/2 bits (noise limited), boxcar of the
+     * averaged result has -3dB bandwidth of 0.443 of the result rate */
+    uint8_t half = 24+ANALOG.settings.sampnum;
+    if(half>(ANALOG.bits*2)) { half = ANALOG.bits*2; }
+    DISPLAY_CursorPosition(6,41);
+    printf_P(TEXT_ADC_BANDWIDTH, half/2, (half&1)*5, (ANALOG_Rate()*443)/1000);
+    DISPLAY_InvertLine(0);
+    DISPLAY_SelectLine();
+}
+
+/* KEY3+KEY4 switches between the ADC and the filter page */
+static void ANALOG_SettingsKeyUp(KEYPAD_KEY_t key) {
+    if(ANALOG.page) {
+        ANALOG_FilterKeyUp(key);
+        return;
+    }
+    switch(key) {
+    case KEYPAD_KEY1:
+        if((ANALOG.settings.prescaler++)==ANALOG_PRESCALER_DIV512) {
+            ANALOG.settings.prescaler = ANALOG_PRESCALER_DIV32;
+        }
+        DISPLAY_Select(14);
+        break;
+    case KEYPAD_KEY2:
+        if((ANALOG.settings.sampnum++)==ANALOG_SAMPNUM_64X) {
+            ANALOG.settings.sampnum = ANALOG.bits-12;
+        }
+        DISPLAY_Select(23);
+        break;
+    case KEYPAD_KEY3:
+        ANALOG.settings.sampval = (ANALOG.settings.sampval<SAMPVAL_MAX) ? ((ANALOG.settings.sampval<<1)|1) : 0;
+        DISPLAY_Select(32);
+        break;
+    case KEYPAD_KEY4:
+        ANALOG_SaveSettings();
+        ANALOG_Setup();
+        ANALOG_RangeReset();
+        CHART_Clear();
+        KEYPAD_KeyUp(ANALOG_KeyUp);
+        MAIN_Loop(ANALOG_Flush);
+        BUFFER_Clear();
+        EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+        break;
+    case KEYPAD_KEY34:
+        ANALOG.page = 1;
+        DISPLAY_Select(-1);
+        break;
+    default:
+        break;
+    }
+}
+
+static void ANALOG_FilterLoop(void) {
+    static const __flash char* const __flash MODE[] = {
+        [FILTER_MODE_OFF] = TEXT_OFF,
+        [FILTER_MODE_BOXCAR] = TEXT_FILTER_BOXCAR,
+        [FILTER_MODE_IIR] = TEXT_FILTER_IIR,
+        [FILTER_MODE_NOTCH50] = TEXT_FILTER_NOTCH50,
+        [FILTER_MODE_NOTCH60] = TEXT_FILTER_NOTCH60,
+    };
+    const FILTER_MODE_t mode = ANALOG.settings.filter;
+    const uint8_t order = ANALOG.settings.order;
+    DISPLAY_CursorPosition(12, 1);
+    puts_P(TEXT_ADC_FILTER);
+    DISPLAY_CursorPosition(6,15);
+    printf_P(TEXT_FILTER_MODE, MODE[mode]);
+    if((mode==FILTER_MODE_BOXCAR)||(mode==FILTER_MODE_IIR)) {
+        DISPLAY_CursorPosition(6,24);
+        printf_P(TEXT_FILTER_LENGTH, 1<<order);
+        DISPLAY_CursorPosition(6,33);
+        printf_P(TEXT_FILTER_CUTOFF, FILTER_Cutoff(mode, order, ANALOG_Rate()));
+    } else if(mode) {
+        DISPLAY_CursorPosition(6,24);
+        printf_P(TEXT_FILTER_WIDTH, FILTER_NOTCH_WIDTH);
+        if(!FILTER_Usable(mode, ANALOG_Rate())) {
+            DISPLAY_CursorPosition(6,33);
+            puts_P(TEXT_FILTER_RATE);
+        }
+    }
+    DISPLAY_InvertLine(0);
+    DISPLAY_SelectLine();
+}
+
+/* KEY1 mode, KEY2 length, KEY4 saves as on the ADC page */
+static void ANALOG_FilterKeyUp(KEYPAD_KEY_t key) {
+    switch(key) {
+    case KEYPAD_KEY1:
+        if((ANALOG.settings.filter++)==FILTER_MODE_NOTCH60) {
+            ANALOG.settings.filter = FILTER_MODE_OFF;
+        }
+        if(ANALOG.settings.order>FILTER_OrderMax(ANALOG.settings.filter)) {
+            ANALOG.settings.order = 1;
+        }
+        DISPLAY_Select(14);
+        break;
+    case KEYPAD_KEY2:
+        if((ANALOG.settings.order++)>=FILTER_OrderMax(ANALOG.settings.filter)) {
+            ANALOG.settings.order = 1;
+        }
+        DISPLAY_Select(23);
+        break;
+    case KEYPAD_KEY4:
+        ANALOG.page = 0;
+        ANALOG_SettingsKeyUp(KEYPAD_KEY4);
+        break;
+    case KEYPAD_KEY34:
+        ANALOG.page = 0;
+        DISPLAY_Select(-1);
+        break;
+    default:
+        break;
+    }
+}
+
 ISR(TCC5_OVF_vect) {
     TCC5_INTFLAGS = TC5_OVFIF_bm;
     ANALOG.update = 1;
+    ANALOG.glitch.period++;
 }
 
 ISR(ADCA_CH0_vect) {
     static uint8_t idx = 0;
+    if(ANALOG.Interrupt) {
+        ANALOG.Interrupt();
+        return;
+    }
+    if(ANALOG.glitch.mode) {
+        int16_t sample = ADCA_CH0RES;
+        uint16_t period = ANALOG.glitch.period;
+        uint16_t ticks = TCC5_CNT;
+        if((TCC5_INTFLAGS&TC5_OVFIF_bm)&&(ticks<(RESULT_REFRESH*125/2))) {
+            period++; // overflow is pending
+        }
+        uint32_t time = ((uint32_t)period*(RESULT_REFRESH*125))+ticks;
+        if((time-ANALOG.glitch.last)>GLITCH_GAP) {
+            ANALOG.glitch.time = time;
+            ANALOG.glitch.peak = sample;
+            ANALOG.glitch.count++;
+        } else if(ANALOG.glitch.mode==ANALOG_GLITCH_ABOVE) {
+            if(sample>ANALOG.glitch.peak) { ANALOG.glitch.peak = sample; }
+        } else {
+            if(sample<ANALOG.glitch.peak) { ANALOG.glitch.peak = sample; }
+        }
+        ANALOG.glitch.last = time;
+        return;
+    }
     switch(ADCA_CH0_INTCTRL&ADC_CH_INTMODE_gm) {
     case ADC_CH_INTMODE_BELOW_gc:
         if(++idx>2) {
@@ -235,6 +1248,7 @@ ISR(ADCA_CH0_vect) {
 
 ISR(XCL_UNF_vect) {
     XCL_INTFLAGS = XCL_UNF0IF_bm;
+    if(ANALOG.glitch.mode||ANALOG.scope.state||ANALOG.Interrupt) { return; }
     ADCA_CH0_INTCTRL = ADC_CH_INTMODE_COMPLETE_gc|ADC_CH_INTLVL_OFF_gc;
     if(!ANALOG.hold) {
         EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
@@ -242,6 +1256,9 @@ ISR(XCL_UNF_vect) {
 }
 
 void ANALOG_Calibration(void) {
+    ANALOG.calibration.page = 0;
+    ANALOG.calibration.point = 0;
+    ANALOG.calibration.step = 10;
     DISPLAY_Mode(DISPLAY_MODE_EDMA);
     MAIN_Loop(ANALOG_CalibrationUpdate);
     KEYPAD_KeyUp(ANALOG_CalibrationKeyUp);
@@ -250,66 +1267,211 @@ void ANALOG_Calibration(void) {
 }
 
 static void ANALOG_CalibrationUpdate(void) {
-    static int16_t sample;
     if(!DISPLAY_Update()) { return; }
     if(ANALOG.update) {
         ANALOG.update = 0;
-        sample = ADCA_CH0RES;
+        ANALOG.calibration.sample = ANALOG_RangeNormalize(ADCA_CH0RES, ANALOG.range.adc);
     }
     DISPLAY_CursorPosition(15, 1);
     puts_P(TEXT_ADC_CALIBRATION);
     DISPLAY_CursorPosition(8, 15);
     puts_P(TEXT_ADC_VALUE);
-    if(ANALOG.Result) { ANALOG.Result(sample); }
+    ANALOG_Print(ANALOG.calibration.sample);
+    if(ANALOG.calibration.page) {
+        const uint8_t point = ANALOG.calibration.point;
+        DISPLAY_CursorPosition(2, 24);
+        printf_P(TEXT_ADC_POINT, point+1);
+        if(ANALOG.Result) { ANALOG.Result(ANALOG.settings.point[point].value); }
+        DISPLAY_CursorPosition(2, 33);
+        if(ANALOG.settings.points&(1<<point)) {
+            printf_P(TEXT_ADC_RAW, ANALOG.settings.point[point].raw);
+        } else {
+            puts_P(TEXT_ADC_RAW_NONE);
+        }
+        DISPLAY_CursorPosition(2, 41);
+        printf_P(TEXT_ADC_STEP, ANALOG.calibration.step);
+        DISPLAY_InvertLine(0);
+        DISPLAY_SelectLine();
+        return;
+    }
     DISPLAY_CursorPosition(2, 24);
-    printf_P(TEXT_ADC_OFFSET, ANALOG.settings.offset);
+    printf_P(TEXT_ADC_OFFSET, *ANALOG_Offset(ANALOG.range.adc));
     DISPLAY_CursorPosition(14, 33);
-    uint16_t gain = ANALOG.settings.gain;
+    uint16_t gain = *ANALOG_Gain(ANALOG.range.adc);
     uint8_t integer = gain>>11;
     uint16_t fraction = (gain>>1)&0x03FF;
     if(fraction>0x0200) { fraction = 999-(0x03FF-fraction); }
     printf_P(TEXT_ADC_GAIN, integer, fraction);
+    DISPLAY_CursorPosition(8, 41);
+    printf_P(TEXT_ADC_RANGE, 1<<(ANALOG.range.adc-ANALOG.range.base));
     DISPLAY_InvertLine(0);
     DISPLAY_SelectLine();
 }
 
+/* Points page: KEY1 selects a point, KEY2/KEY3 adjust its reference,
+ * KEY4 captures the reading, KEY2+KEY3 removes the point, KEY1+KEY2
+ * changes the adjustment step, KEY3+KEY4 switches the page */
+static void ANALOG_CalibrationPointKeyUp(KEYPAD_KEY_t key) {
+    ANALOG_POINT_t* point = &ANALOG.settings.point[ANALOG.calibration.point];
+    const int16_t step = ANALOG.calibration.step;
+    switch(key) {
+    case KEYPAD_KEY1:
+        if(++ANALOG.calibration.point>=ANALOG_POINTS) {
+            ANALOG.calibration.point = 0;
+        }
+        DISPLAY_Select(23);
+        break;
+    case KEYPAD_KEY2:
+        point->value = (point->value>(LEVEL_MIN+step)) ? (point->value-step) : LEVEL_MIN;
+        DISPLAY_Select(23);
+        break;
+    case KEYPAD_KEY3:
+        point->value = (point->value<(LEVEL_MAX-step)) ? (point->value+step) : LEVEL_MAX;
+        DISPLAY_Select(23);
+        break;
+    case KEYPAD_KEY4:
+        point->raw = ANALOG.calibration.sample;
+        ANALOG.settings.points |= (1<<ANALOG.calibration.point);
+        ANALOG_PointsSort();
+        DISPLAY_Select(32);
+        break;
+    case KEYPAD_KEY23:
+        ANALOG.settings.points &= ~(1<<ANALOG.calibration.point);
+        ANALOG_PointsSort();
+        DISPLAY_Select(32);
+        break;
+    case KEYPAD_KEY12:
+        ANALOG.calibration.step *= 10;
+        if(ANALOG.calibration.step>STEP_MAX) { ANALOG.calibration.step = 1; }
+        DISPLAY_Select(40);
+        break;
+    case KEYPAD_KEY34:
+        ANALOG.calibration.page = 0;
+        DISPLAY_Select(-1);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Offset and gain are adjusted for the selected range (KEY1+KEY2) */
 static void ANALOG_CalibrationKeyUp(KEYPAD_KEY_t key) {
-    int16_t offset = ANALOG.settings.offset;
-    uint16_t gain = ANALOG.settings.gain;
+    int16_t* offset = ANALOG_Offset(ANALOG.range.adc);
+    uint16_t* gain = ANALOG_Gain(ANALOG.range.adc);
+    if(ANALOG.calibration.page) {
+        ANALOG_CalibrationPointKeyUp(key);
+        key = KEYPAD_KEY0;
+    }
     switch(key) {
     case KEYPAD_KEY1:
-        if(offset>OFFSET_MIN) { ANALOG.settings.offset--; }
+        if(*offset>OFFSET_MIN) { (*offset)--; }
         DISPLAY_Select(23);
         break;
     case KEYPAD_KEY2:
-        if(offset<OFFSET_MAX) { ANALOG.settings.offset++; }
+        if(*offset<OFFSET_MAX) { (*offset)++; }
         DISPLAY_Select(23);
         break;
     case KEYPAD_KEY3:
-        if(gain>GAIN_MIN) { ANALOG.settings.gain-=2; }
+        if(*gain>GAIN_MIN) { *gain-=2; }
         DISPLAY_Select(32);
         break;
     case KEYPAD_KEY4:
-        if(gain<GAIN_MAX) { ANALOG.settings.gain+=2; }
+        if(*gain<GAIN_MAX) { *gain+=2; }
         DISPLAY_Select(32);
         break;
+    case KEYPAD_KEY12:
+        if((ANALOG.range.adc++)==ANALOG_RANGE_64X) {
+            ANALOG.range.adc = ANALOG.range.base;
+        }
+        ANALOG_RangeSet(ANALOG.range.adc);
+        DISPLAY_Select(40);
+        break;
+    case KEYPAD_KEY34:
+        ANALOG.calibration.page = 1;
+        DISPLAY_Select(-1);
+        break;
     default:
         break;
     }
     ANALOG_SaveSettings();
     ANALOG_CalibrationSetup();
+    ANALOG_CorrectionSetup();
 }
 
 static inline void ANALOG_CalibrationSetup(void) {
-    int16_t offset = ANALOG.settings.offset;
+    int16_t offset = *ANALOG_Offset(ANALOG.range.adc);
     ADCA.CH0.OFFSETCORR0 = 0xFF&(((uint16_t)offset)>>0);
     ADCA.CH0.OFFSETCORR1 = 0x0F&(((uint16_t)offset)>>8);
-    uint16_t gain = ANALOG.settings.gain;
+    uint16_t gain = *ANALOG_Gain(ANALOG.range.adc);
     ADCA.CH0.GAINCORR0 = 0xFF&(gain>>0);
     ADCA.CH0.GAINCORR1 = 0x0F&(gain>>8);
     ADCA.CH0.CORRCTRL = ADC_CH_CORREN_bm;
 }
 
+/* Captured points are moved to the front of settings.point[] and sorted by
+ * reading, the selected point is followed, a point captured at the same
+ * reading as another one replaces it */
+static void ANALOG_PointsSort(void) {
+    ANALOG_POINT_t* point = ANALOG.settings.point;
+    uint8_t points = ANALOG.settings.points;
+    uint8_t selected = ANALOG.calibration.point;
+    for(uint8_t i=0; i<ANALOG_POINTS; i++) {
+        for(uint8_t j=i+1; j<ANALOG_POINTS; j++) {
+            if(!(points&(1<<i))||!(points&(1<<j))||(point[i].raw!=point[j].raw)) { continue; }
+            points &= ~(1<<((j==selected) ? i : j)); // same reading twice
+        }
+    }
+    for(uint8_t i=1; i<ANALOG_POINTS; i++) {
+        for(uint8_t j=i; j>0; j--) {
+            const uint8_t low = 1<<(j-1);
+            const uint8_t high = 1<<j;
+            if(!(points&high)||((points&low)&&(point[j-1].raw<=point[j].raw))) { break; }
+            const ANALOG_POINT_t swap = point[j];
+            point[j] = point[j-1];
+            point[j-1] = swap;
+            if(!(points&low)) { points ^= low|high; }
+            if(selected==j) {
+                selected = j-1;
+            } else if(selected==(j-1)) {
+                selected = j;
+            }
+        }
+    }
+    ANALOG.settings.points = points;
+    ANALOG.calibration.point = selected;
+}
+
+/* Slope of the segment from each captured point to the next one is
+ * precomputed (the last segment is extrapolated) */
+static void ANALOG_CorrectionSetup(void) {
+    const ANALOG_POINT_t* point = ANALOG.settings.point;
+    uint8_t count = 0;
+    while((count<ANALOG_POINTS)&&(ANALOG.settings.points&(1<<count))) { count++; }
+    ANALOG.correction.slope[0] = 1<<SLOPE_SHIFT; // single point is an offset
+    for(uint8_t i=1; i<count; i++) {
+        int32_t slope = ((int32_t)(point[i].value-point[i-1].value)<<SLOPE_SHIFT);
+        slope /= point[i].raw-point[i-1].raw;
+        if(slope>INT16_MAX) { slope = INT16_MAX; }
+        if(slope<INT16_MIN) { slope = INT16_MIN; }
+        ANALOG.correction.slope[i-1] = slope;
+    }
+    ANALOG.correction.count = count;
+}
+
+/* Segment lookup, then one multiply and a shift */
+static int16_t ANALOG_Correct(int16_t value) {
+    const uint8_t count = ANALOG.correction.count;
+    if(!count) { return value; }
+    const ANALOG_POINT_t* point = ANALOG.settings.point;
+    uint8_t i = 0;
+    while(((i+2)<count)&&(value>=point[i+1].raw)) { i++; }
+    int32_t result = ((int32_t)(value-point[i].raw)*ANALOG.correction.slope[i])>>SLOPE_SHIFT;
+    result += point[i].value;
+    if(result>INT16_MAX) { result = INT16_MAX; }
+    if(result<INT16_MIN) { result = INT16_MIN; }
+    return result;
+}
+
 void ANALOG_Info(void) {
     DISPLAY_CursorPosition(14, 1);
     DISPLAY_Icon(ICON_SLOWER);
@@ -323,10 +1485,10 @@ void ANALOG_Info(void) {
     DISPLAY_Icon(ICON_HOLD_RUN);
     DISPLAY_CursorPosition(29, 20);
     puts_P(TEXT_HOLD_RUN);
-    DISPLAY_CursorPosition(13, 28);
-    DISPLAY_Icon(ICON_LOCK);
+    DISPLAY_CursorPosition(14, 28);
+    DISPLAY_Icon(ICON_DISPLAY);
     DISPLAY_CursorPosition(29, 29);
-    puts_P(TEXT_SCALE);
+    puts_P(TEXT_STATS);
     DISPLAY_Icons(ANALOG_ICONS);
     DISPLAY_Send();
     DELAY_Info();
@@ -344,9 +1506,73 @@ static inline void ANALOG_LoadSettings(void) {
     if((ANALOG.settings.gain<GAIN_MIN)||(ANALOG.settings.gain>GAIN_MAX)) {
         ANALOG.settings.gain = GAIN_MID;
     }
+    for(uint8_t i=0; i<ANALOG_RANGES; i++) {
+        ANALOG_CORRECTION_t* range = &ANALOG.settings.range[i];
+        if((range->offset<OFFSET_MIN)||(range->offset>OFFSET_MAX)) {
+            range->offset = OFFSET_MID;
+        }
+        if((range->gain<GAIN_MIN)||(range->gain>GAIN_MAX)) {
+            range->gain = GAIN_MID;
+        }
+    }
     if(ANALOG.settings.speed>CHART_SPEED_10) {
         ANALOG.settings.speed = CHART_SPEED_1;
     }
+    if(ANALOG.settings.stat>ANALOG_STAT_CREST) {
+        ANALOG.settings.stat = ANALOG_STAT_VALUE;
+    }
+    if(ANALOG.settings.window>ANALOG_WINDOW_16K) {
+        ANALOG.settings.window = ANALOG_WINDOW_1K;
+    }
+    ANALOG_SCOPE_t* scope = &ANALOG.settings.scope;
+    if(scope->edge>ANALOG_EDGE_BOTH) {
+        scope->edge = ANALOG_EDGE_RISING;
+    }
+    if(scope->trigger>ANALOG_TRIGGER_SINGLE) {
+        scope->trigger = ANALOG_TRIGGER_AUTO;
+    }
+    if(scope->pre>ANALOG_PRE_75) {
+        scope->pre = ANALOG_PRE_25;
+    }
+    if(scope->base>ANALOG_BASE_8) {
+        scope->base = ANALOG_BASE_1;
+    }
+    if((scope->level<LEVEL_MIN)||(scope->level>LEVEL_MAX)) {
+        scope->level = 0;
+    }
+    if(ANALOG.settings.prescaler>ANALOG_PRESCALER_DIV512) {
+        ANALOG.settings.prescaler = ANALOG_PRESCALER_DIV32;
+    }
+    if((ANALOG.settings.sampnum<(ANALOG.bits-12))||(ANALOG.settings.sampnum>ANALOG_SAMPNUM_64X)) {
+        ANALOG.settings.sampnum = ANALOG_SAMPNUM_8X;
+    }
+    if(ANALOG.settings.filter>FILTER_MODE_NOTCH60) {
+        ANALOG.settings.filter = FILTER_MODE_OFF;
+    }
+    if((ANALOG.settings.order<1)||(ANALOG.settings.order>FILTER_OrderMax(ANALOG.settings.filter))) {
+        ANALOG.settings.order = 1;
+    }
+    if(ANALOG.settings.fft>ANALOG_FFT_512) {
+        ANALOG.settings.fft = ANALOG_FFT_256;
+    }
+    if(ANALOG.settings.points>=(1<<ANALOG_POINTS)) {
+        ANALOG.settings.points = 0;
+    }
+    for(uint8_t i=0; i<ANALOG_POINTS; i++) {
+        ANALOG_POINT_t* point = &ANALOG.settings.point[i];
+        if((point->value<LEVEL_MIN)||(point->value>LEVEL_MAX)) {
+            point->value = 0;
+        }
+        if((point->raw<LEVEL_MIN)||(point->raw>LEVEL_MAX)) {
+            ANALOG.settings.points &= ~(1<<i);
+            point->raw = 0;
+        }
+    }
+    ANALOG_PointsSort();
+    const uint8_t sampval = ANALOG.settings.sampval;
+    if((sampval>SAMPVAL_MAX)||(sampval&(sampval+1))) {
+        ANALOG.settings.sampval = 1;
+    }
     ANALOG_SaveSettings();
 }
 
@@ -354,5 +1580,5 @@ const __flash uint8_t* const __flash ANALOG_ICONS[] = {
     ICON_SLOWER,
     ICON_FASTER,
     ICON_HOLD_RUN,
-    ICON_LOCK,
+    ICON_DISPLAY,
 };
@@ -17,17 +17,136 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #define ANALOG_H_INCLUDED
 
 #include "chart.h"
+#include "filter.h"
+
+#define ANALOG_RATE_NOMINAL  13889 // Hz, DIV32, 8X, SAMPVAL=1
+#define ANALOG_POINTS  7 // multi-point calibration
+
+typedef enum {
+    ANALOG_STAT_VALUE,
+    ANALOG_STAT_MEAN,
+    ANALOG_STAT_RMS,
+    ANALOG_STAT_STD,
+    ANALOG_STAT_PP,
+    ANALOG_STAT_CREST,
+} ANALOG_STAT_t;
+
+typedef enum {
+    ANALOG_WINDOW_256,
+    ANALOG_WINDOW_1K,
+    ANALOG_WINDOW_4K,
+    ANALOG_WINDOW_16K,
+} ANALOG_WINDOW_t;
+
+typedef enum {
+    ANALOG_EDGE_RISING,
+    ANALOG_EDGE_FALLING,
+    ANALOG_EDGE_BOTH,
+} ANALOG_EDGE_t;
+
+typedef enum {
+    ANALOG_TRIGGER_AUTO,
+    ANALOG_TRIGGER_NORMAL,
+    ANALOG_TRIGGER_SINGLE,
+} ANALOG_TRIGGER_t;
+
+typedef enum {
+    ANALOG_PRE_0,
+    ANALOG_PRE_25,
+    ANALOG_PRE_50,
+    ANALOG_PRE_75,
+} ANALOG_PRE_t;
+
+typedef enum {
+    ANALOG_BASE_1,
+    ANALOG_BASE_2,
+    ANALOG_BASE_3,
+    ANALOG_BASE_4,
+    ANALOG_BASE_6,
+    ANALOG_BASE_8,
+} ANALOG_BASE_t;
+
+typedef enum {
+    ANALOG_PRESCALER_DIV32,
+    ANALOG_PRESCALER_DIV64,
+    ANALOG_PRESCALER_DIV128,
+    ANALOG_PRESCALER_DIV256,
+    ANALOG_PRESCALER_DIV512,
+} ANALOG_PRESCALER_t;
+
+typedef enum {
+    ANALOG_SAMPNUM_1X,
+    ANALOG_SAMPNUM_2X,
+    ANALOG_SAMPNUM_4X,
+    ANALOG_SAMPNUM_8X,
+    ANALOG_SAMPNUM_16X,
+    ANALOG_SAMPNUM_32X,
+    ANALOG_SAMPNUM_64X,
+} ANALOG_SAMPNUM_t;
+
+typedef enum {
+    ANALOG_RANGE_DIV2,
+    ANALOG_RANGE_1X,
+    ANALOG_RANGE_2X,
+    ANALOG_RANGE_4X,
+    ANALOG_RANGE_8X,
+    ANALOG_RANGE_16X,
+    ANALOG_RANGE_32X,
+    ANALOG_RANGE_64X,
+} ANALOG_RANGE_t;
+
+#define ANALOG_RANGES  (ANALOG_RANGE_64X+1)
+
+typedef enum {
+    ANALOG_FFT_256,
+    ANALOG_FFT_512,
+} ANALOG_FFT_t;
+
+typedef struct {
+    ANALOG_EDGE_t edge;
+    ANALOG_TRIGGER_t trigger;
+    ANALOG_PRE_t pre;
+    ANALOG_BASE_t base;
+    int16_t level;
+} ANALOG_SCOPE_t;
+
+typedef struct {
+    int16_t offset;
+    uint16_t gain;
+} ANALOG_CORRECTION_t;
+
+typedef struct {
+    int16_t raw; // reading with OFFSETCORR/GAINCORR applied
+    int16_t value; // reference
+} ANALOG_POINT_t;
 
 typedef struct {
     int16_t offset;
     uint16_t gain;
     CHART_SPEED_t speed;
+    ANALOG_STAT_t stat;
+    ANALOG_WINDOW_t window;
+    ANALOG_SCOPE_t scope;
+    ANALOG_PRESCALER_t prescaler;
+    ANALOG_SAMPNUM_t sampnum;
+    uint8_t sampval;
+    ANALOG_FFT_t fft;
+    uint8_t points; // bit mask of captured points
+    ANALOG_POINT_t point[ANALOG_POINTS];
+    ANALOG_CORRECTION_t range[ANALOG_RANGES]; // offset and gain above are used for the base range
+    FILTER_MODE_t filter;
+    uint8_t order; // boxcar length or IIR time constant (2^n samples)
 } ANALOG_SETTINGS_t;
 
 typedef void (*ANALOG_Result_t)(int16_t value);
+typedef void (*ANALOG_Interrupt_t)(void);
 
-void ANALOG_Init(ANALOG_SETTINGS_t* settings);
+void ANALOG_Init(ANALOG_SETTINGS_t* settings, uint8_t bits);
 void ANALOG_Result(ANALOG_Result_t Result);
+void ANALOG_Interrupt(ANALOG_Interrupt_t Interrupt);
+uint8_t ANALOG_Refresh(void);
+uint32_t ANALOG_Rate(void);
+void ANALOG_Correction(ANALOG_SETTINGS_t* settings, int16_t* offset, uint16_t* gain);
 void ANALOG_Calibration(void);
 void ANALOG_Info(void);
 
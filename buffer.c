@@ -26,6 +26,12 @@ void BUFFER_Init(BUFFER_MODE_t mode) {
     BUFFER.flush = 0;
     BUFFER.mode = mode;
     if(mode==BUFFER_MODE_USART_RX) {
+        /* Timer TCD5 (2us) timestamps every received byte, it is not used
+         * by the display in RAW mode */
+        BUFFER.wrap = 0;
+        TCD5.CTRLB = TC45_BYTEM_NORMAL_gc|TC45_WGMODE_NORMAL_gc;
+        TCD5.INTCTRLA = TC45_OVFINTLVL_LO_gc;
+        TCD5.CTRLA = TC45_CLKSEL_DIV64_gc;
         USARTC0_STATUS = USART_RXCIF_bm;
         USARTD0_STATUS = USART_RXCIF_bm;
         USARTC0_CTRLA = USART_RXCINTLVL_LO_gc;
@@ -143,12 +149,37 @@ void BUFFER_Reduce(void) {
         if(BUFFER.mode!=BUFFER_MODE_USART_RX) {
             BUFFER.last = BUFFER_EDMA_Last();
         }
-        BUFFER.first = BUFFER.last+2;
+        BUFFER.first = BUFFER.last+4;
         BUFFER.first &= BUFFER_MAX;
         BUFFER.page = 0;
     }
 }
 
+/* Number of bytes that could be read directly from BUFFER.data starting at
+ * BUFFER.first, without wrapping around the end of the buffer. */
+uint16_t BUFFER_Block(void) {
+    uint16_t size;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if(BUFFER.mode!=BUFFER_MODE_USART_RX) {
+            BUFFER.last = BUFFER_EDMA_Last();
+        }
+        if(BUFFER.last>=BUFFER.first) {
+            size = BUFFER.last-BUFFER.first;
+        } else {
+            size = sizeof(BUFFER.data)-BUFFER.first;
+        }
+    }
+    return size;
+}
+
+void BUFFER_Release(uint16_t size) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        BUFFER.first += size;
+        BUFFER.first &= BUFFER_MAX;
+        if(BUFFER.first==0 && BUFFER.page>0) { BUFFER.page--; }
+    }
+}
+
 uint8_t BUFFER_Overflow(void) {
     uint16_t use = 0;
     ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
@@ -170,18 +201,62 @@ static inline void BUFFER_NewData(uint8_t data) {
     if(BUFFER.last==0) { BUFFER.page++; }
 }
 
+/* Overflow not handled yet (interrupts are off), the count wrapped after it
+ * only if it is still low */
+static inline uint8_t BUFFER_Wrapped(uint16_t time) {
+    return (TCD5_INTFLAGS&TC5_OVFIF_bm)&&(time<0x8000);
+}
+
+/* Time since previous byte (in 2us units), saturated at UINT16_MAX */
+static inline uint16_t BUFFER_Elapsed(uint16_t time) {
+    uint8_t wrap = BUFFER.wrap;
+    if(BUFFER_Wrapped(time)) { wrap++; }
+    uint16_t gap = time-BUFFER.time;
+    if((wrap>1)||(wrap&&(time>=BUFFER.time))) {
+        gap = UINT16_MAX;
+    }
+    return gap;
+}
+
+uint16_t BUFFER_Idle(void) {
+    uint16_t idle;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        idle = BUFFER_Elapsed(TCD5_CNT);
+    }
+    return idle;
+}
+
+static inline void BUFFER_NewTime(void) {
+    uint16_t time = TCD5_CNT;
+    uint16_t gap = BUFFER_Elapsed(time);
+    BUFFER.time = time;
+    BUFFER.wrap = 0;
+    if(BUFFER_Wrapped(time)) {
+        TCD5_INTFLAGS = TC5_OVFIF_bm; // already counted in this gap
+    }
+    BUFFER_NewData(gap);
+    BUFFER_NewData(gap>>8);
+}
+
 ISR(USARTC0_RXC_vect) {
-    uint8_t status = USARTC0_STATUS&(USART_FERR_bm|USART_PERR_bm);
+    uint8_t status = USARTC0_STATUS&(USART_FERR_bm|USART_PERR_bm|USART_RXB8_bm);
     BUFFER_NewData(status|USART_RXCIF_bm);
+    BUFFER_NewTime();
     BUFFER_NewData(USARTC0_DATA);
 }
 
 ISR(USARTD0_RXC_vect) {
-    uint8_t status = USARTD0_STATUS&(USART_FERR_bm|USART_PERR_bm);
+    uint8_t status = USARTD0_STATUS&(USART_FERR_bm|USART_PERR_bm|USART_RXB8_bm);
     BUFFER_NewData(status|USART_TXCIF_bm);
+    BUFFER_NewTime();
     BUFFER_NewData(USARTD0_DATA);
 }
 
+ISR(TCD5_OVF_vect) {
+    TCD5_INTFLAGS = TC5_OVFIF_bm;
+    if(BUFFER.wrap<2) { BUFFER.wrap++; }
+}
+
 ISR(EDMA_CH0_vect) {
     EDMA_INTFLAGS = EDMA_CH0TRNFIF_bm;
     EDMA_CH0_CTRLA |= EDMA_CH_REPEAT_bm;
@@ -37,6 +37,8 @@ struct {
     volatile uint16_t last;
     uint8_t flush;
     volatile uint8_t page;
+    uint16_t time;
+    volatile uint8_t wrap;
     BUFFER_MODE_t mode;
     union {
         uint8_t data[BUFFER_SIZE];
@@ -50,8 +52,11 @@ void BUFFER_Stop(void);
 void BUFFER_Clear(void);
 uint8_t BUFFER_Flush(void);
 uint8_t BUFFER_Empty(void);
+uint16_t BUFFER_Idle(void);
 uint8_t BUFFER_Overflow(void);
 void BUFFER_Reduce(void);
+uint16_t BUFFER_Block(void);
+void BUFFER_Release(uint16_t size);
 
 static inline uint8_t BUFFER_GetData(void) {
     uint8_t data;
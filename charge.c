@@ -30,28 +30,50 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "icon.h"
 #include "current.h"
 #include "chart.h"
+#include "power.h"
 #include "charge.h"
 
 #define CALIB_TIME  4 // 4s
 #define GAIN 2 // Input signal gain (x2)
+#define OFFSET_SHIFT  4 // energy mode current offset resolution (1/16 LSB)
+#define ENERGY_UWS  128 // energy is in 1/128uWs (1mV * 0.125mA / 16 per second)
+#define CHART_SHIFT  17 // 1/128uW << 17 = 1.024mW per chart unit
+
+typedef enum {
+    CHARGE_MODE_CHARGE,
+    CHARGE_MODE_ENERGY,
+} CHARGE_MODE_t;
+
+typedef enum {
+    CHARGE_VIEW_VALUE,
+    CHARGE_VIEW_TIMER,
+    CHARGE_VIEW_AVERAGE, // energy mode only
+} CHARGE_VIEW_t;
 
 typedef struct {
     CHART_SPEED_t speed;
+    CHARGE_MODE_t mode;
 } CHARGE_SETTINGS_t;
 
 static CHARGE_SETTINGS_t CHARGE_settings EEMEM;
 static struct CHARGE_struct {
     volatile uint8_t update;
-    uint16_t count, period;
-    uint8_t timer;
+    uint16_t count;
+    uint32_t period;
+    CHARGE_VIEW_t view;
     int16_t max;
     int32_t total, accum, value, offset;
+    /* 100h at 8W is 3.7e14 (1/128uWs), far below the 64-bit limit */
+    struct {
+        int64_t accum, value;
+    } energy;
     struct {
         volatile uint8_t hour, minute, second;
     } time;
     CHARGE_SETTINGS_t settings;
 } CHARGE;
 
+static void CHARGE_Start(void);
 static void CHARGE_Flush(void);
 static void CHARGE_Calibration(void);
 static void CHARGE_Clear(void);
@@ -60,6 +82,8 @@ static void CHARGE_KeyUp(KEYPAD_KEY_t key);
 static void CHARGE_Info(void);
 static void CHARGE_Icons(void);
 static inline void CHARGE_Result(void);
+static inline void CHARGE_Energy(void);
+static inline void CHARGE_Average(void);
 static inline void CHARGE_Timer(void);
 static inline void CHARGE_ChangeCount(void);
 static inline void CHARGE_SaveSettings(void);
@@ -67,8 +91,20 @@ static inline void CHARGE_LoadSettings(void);
 
 void CHARGE_Init(void) {
     CHARGE_LoadSettings();
-    CURRENT_Setup();
     CHARGE_Info();
+    CHARGE_Start();
+}
+
+/* Energy mode converts voltage and current alternately (see POWER), the
+ * current offset is calibrated the same way with shorted current input */
+static void CHARGE_Start(void) {
+    if(CHARGE.settings.mode==CHARGE_MODE_ENERGY) {
+        POWER_Setup();
+        POWER_Offset(1);
+    } else {
+        CURRENT_Setup();
+        ADCA_CH0_MUXCTRL = ADC_CH_MUXPOS_PIN6_gc|ADC_CH_MUXNEGH_PIN6_gc;
+    }
     MAIN_Loop(CHARGE_Flush);
     KEYPAD_KeyUp(NULL);
     PORTD_PIN6CTRL = PORT_ISC_RISING_gc;
@@ -80,8 +116,7 @@ void CHARGE_Init(void) {
     TCC5.INTCTRLB = TC45_CCAINTLVL_OFF_gc|TC45_CCBINTLVL_OFF_gc;
     XCL_INTCTRL = XCL_UNF_INTLVL_OFF_gc;
     XCL_CTRLE = XCL_CLKSEL_OFF_gc;
-    ADCA_CH0_MUXCTRL = ADC_CH_MUXPOS_PIN6_gc|ADC_CH_MUXNEGH_PIN6_gc;
-    CHARGE.timer = 0;
+    CHARGE.view = CHARGE_VIEW_VALUE;
 }
 
 static void CHARGE_Flush(void) {
@@ -89,6 +124,7 @@ static void CHARGE_Flush(void) {
         CHARGE.value = 0;
         CHARGE.max = 0;
         CHARGE.offset = 0;
+        CHARGE.period = 0;
         CHARGE_ChangeCount();
         EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
         BUFFER_Clear();
@@ -99,16 +135,28 @@ static void CHARGE_Flush(void) {
         TCC5.INTFLAGS = TC5_CCBIF_bm;
         TCC5.INTCTRLB = TC45_CCBINTLVL_LO_gc;
         TCC5.CTRLA = TC45_CLKSEL_EVCH5_gc;
-        ADCA_CTRLA |= ADC_FLUSH_bm;
-        EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+        if(CHARGE.settings.mode==CHARGE_MODE_ENERGY) {
+            POWER_Start();
+        } else {
+            ADCA_CTRLA |= ADC_FLUSH_bm;
+            EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+        }
         MAIN_Loop(CHARGE_Calibration);
     }
 }
 
 static void CHARGE_Calibration(void) {
+    POWER_PAIR_t pair;
     while(!BUFFER_Empty()) {
-        int16_t sample = BUFFER_GetSample();
-        CHARGE.offset += sample;
+        if(CHARGE.settings.mode==CHARGE_MODE_ENERGY) {
+            if(POWER_Sample(&pair)) {
+                CHARGE.offset += pair.current;
+                CHARGE.period++;
+            }
+        } else {
+            int16_t sample = BUFFER_GetSample();
+            CHARGE.offset += sample;
+        }
     }
     if(DISPLAY_Update()){
         CHART_Update();
@@ -118,15 +166,24 @@ static void CHARGE_Calibration(void) {
         puts_P(TEXT_CALIBRATION);
     }
     if(TCC5_INTCTRLB==TC45_CCBINTLVL_OFF_gc) {
-        CHARGE.offset /= CALIB_TIME;
         TCC5.CTRLA = TC45_CLKSEL_OFF_gc;
         TCC5.PER = 1024-1;
         TCC5.CNT = 0;
         TCC5.INTCTRLB = TC45_CCAINTLVL_LO_gc;
         TCC5.CTRLA = TC45_CLKSEL_EVCH5_gc;
-        ADCA_CH0_MUXCTRL = ADC_CH_MUXPOS_PIN7_gc|ADC_CH_MUXNEGH_PIN6_gc;
-        ADCA_CTRLA |= ADC_FLUSH_bm;
-        EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+        if(CHARGE.settings.mode==CHARGE_MODE_ENERGY) {
+            /* Offset of a single current sample with 1/16 LSB resolution */
+            if(CHARGE.period) {
+                CHARGE.offset = (((int64_t)CHARGE.offset)<<OFFSET_SHIFT)/(int32_t)CHARGE.period;
+            }
+            POWER_Offset(0);
+            POWER_Start();
+        } else {
+            CHARGE.offset /= CALIB_TIME;
+            ADCA_CH0_MUXCTRL = ADC_CH_MUXPOS_PIN7_gc|ADC_CH_MUXNEGH_PIN6_gc;
+            ADCA_CTRLA |= ADC_FLUSH_bm;
+            EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+        }
         MAIN_Loop(CHARGE_Clear);
         KEYPAD_KeyUp(CHARGE_KeyUp);
         CHARGE.update = 0;
@@ -138,6 +195,8 @@ static void CHARGE_Clear(void) {
         CHARGE.value = 0;
         CHARGE.accum = 0;
         CHARGE.period = 0;
+        CHARGE.energy.value = 0;
+        CHARGE.energy.accum = 0;
         CHARGE.update = 0;
         CHARGE.time.hour = 0;
         CHARGE.time.minute = 0;
@@ -148,11 +207,21 @@ static void CHARGE_Clear(void) {
 }
 
 static void CHARGE_Loop(void) {
+    POWER_PAIR_t pair;
     while(!BUFFER_Empty()) {
-        int16_t sample = BUFFER_GetSample();
+        int16_t sample;
+        if(CHARGE.settings.mode==CHARGE_MODE_ENERGY) {
+            if(!POWER_Sample(&pair)) { continue; }
+            const int32_t current = (((int32_t)pair.current)<<OFFSET_SHIFT)-CHARGE.offset;
+            const int32_t power = pair.voltage*current; // 1/128uW
+            CHARGE.energy.accum += power;
+            sample = power>>CHART_SHIFT;
+        } else {
+            sample = BUFFER_GetSample();
+            CHARGE.accum += sample;
+        }
         if(sample>CHARGE.max) { CHARGE.max = sample; }
         CHARGE.total += sample;
-        CHARGE.accum += sample;
         CHARGE.period++;
         if(CHART_Sample()) {
             int16_t avg = CHARGE.total/CHARGE.count;
@@ -162,17 +231,31 @@ static void CHARGE_Loop(void) {
         }
     }
     if(CHARGE.update) {
-        CHARGE.accum += (CHARGE.period/2)-CHARGE.offset;
-        CHARGE.value += CHARGE.accum/CHARGE.period;
+        if(CHARGE.settings.mode==CHARGE_MODE_ENERGY) {
+            /* Mean power of the last second, RTC keeps the time base */
+            if(CHARGE.period) {
+                CHARGE.energy.value += CHARGE.energy.accum/(int32_t)CHARGE.period;
+            }
+            CHARGE.energy.accum = 0;
+        } else {
+            CHARGE.accum += (int32_t)(CHARGE.period/2)-CHARGE.offset;
+            CHARGE.value += CHARGE.accum/(int32_t)CHARGE.period;
+        }
         CHARGE.accum = 0;
         CHARGE.period = 0;
         CHARGE.update = 0;
     }
     if(DISPLAY_Update()){
         CHART_Update();
-        if(CHARGE.timer) {
+        if(CHARGE.view==CHARGE_VIEW_TIMER) {
             DISPLAY_CursorPosition(3,1);
             CHARGE_Timer();
+        } else if(CHARGE.view==CHARGE_VIEW_AVERAGE) {
+            DISPLAY_CursorPosition(1,1);
+            CHARGE_Average();
+        } else if(CHARGE.settings.mode==CHARGE_MODE_ENERGY) {
+            DISPLAY_CursorPosition(1,1);
+            CHARGE_Energy();
         } else {
             DISPLAY_CursorPosition(1,1);
             CHARGE_Result();
@@ -208,6 +291,57 @@ static inline void CHARGE_Result(void) {
     puts_P(TEXT_CHARGE_UNIT);
 }
 
+static inline void CHARGE_Energy(void) {
+    int64_t value = CHARGE.energy.value/ENERGY_UWS;
+    char sign = (value<0) ? '-' : ' ';
+    if(value<0) { value = -value; }
+    uint32_t centi = (value+18000)/36000; // 0.01mWh = 36000uWs
+    uint32_t milli = centi/100;
+    const __flash char* unit = TEXT_ENERGY_mWh;
+    if(milli<10) {
+        if(centi==0) { sign = ' '; }
+        printf_P(TEXT_CHARGE_muu, sign, (uint16_t)milli, (uint16_t)(centi%100));
+    } else if(milli<100) {
+        printf_P(TEXT_CHARGE_mmu, sign, (uint16_t)milli, (uint16_t)((centi%100)/10));
+    } else if(milli<10000) {
+        printf_P(TEXT_CHARGE_mmm, sign, (uint16_t)milli);
+    } else if(milli<100000) {
+        unit = TEXT_ENERGY_Wh;
+        printf_P(TEXT_CHARGE_mmu, sign, (uint16_t)(milli/1000), (uint16_t)((milli%1000)/100));
+    } else if(milli<10000000) {
+        unit = TEXT_ENERGY_Wh;
+        printf_P(TEXT_CHARGE_mmm, sign, (uint16_t)(milli/1000));
+    } else {
+        unit = TEXT_ENERGY_Wh;
+        DISPLAY_MoveCursor(6);
+        printf_P(TEXT_OVERLOAD, sign);
+    }
+    DISPLAY_MoveCursor(2);
+    puts_P(unit);
+}
+
+static inline void CHARGE_Average(void) {
+    uint32_t seconds;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        seconds = (CHARGE.time.hour*3600UL)+(CHARGE.time.minute*60)+CHARGE.time.second;
+    }
+    int32_t power = 0;
+    if(seconds) {
+        power = (CHARGE.energy.value/ENERGY_UWS)/(int32_t)seconds; // uW
+    }
+    const char sign = (power<0) ? '-' : ' ';
+    if(power<0) { power = -power; }
+    const uint16_t watt = power/1000000;
+    if(watt<10) {
+        printf_P(TEXT_POWER_VALUE, sign, watt, (uint16_t)((power/1000)%1000));
+    } else {
+        printf_P(TEXT_OVERLOAD, sign);
+        DISPLAY_MoveCursor(6);
+    }
+    DISPLAY_MoveCursor(2);
+    puts_P(TEXT_POWER_UNIT);
+}
+
 static inline void CHARGE_Timer(void) {
     uint8_t hour, minute, second;
     ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
@@ -252,8 +386,23 @@ static void CHARGE_KeyUp(KEYPAD_KEY_t key) {
                 CHARGE_SaveSettings();
             }
             break;
-        case KEYPAD_KEY3: CHARGE.timer = !CHARGE.timer; break;
+        case KEYPAD_KEY3:
+            if(CHARGE.view==CHARGE_VIEW_VALUE) {
+                CHARGE.view = CHARGE_VIEW_TIMER;
+            } else if((CHARGE.view==CHARGE_VIEW_TIMER)&&(CHARGE.settings.mode==CHARGE_MODE_ENERGY)) {
+                CHARGE.view = CHARGE_VIEW_AVERAGE;
+            } else {
+                CHARGE.view = CHARGE_VIEW_VALUE;
+            }
+            break;
         case KEYPAD_KEY4: CHART_Lock(); break;
+        case KEYPAD_KEY12:
+            if((CHARGE.settings.mode++)==CHARGE_MODE_ENERGY) {
+                CHARGE.settings.mode = CHARGE_MODE_CHARGE;
+            }
+            CHARGE_SaveSettings();
+            CHARGE_Start();
+            break;
         default: break;
     }
 }
@@ -305,5 +454,8 @@ static inline void CHARGE_LoadSettings(void) {
     if(CHARGE.settings.speed>CHART_SPEED_4) {
         CHARGE.settings.speed = CHART_SPEED_1;
     }
+    if(CHARGE.settings.mode>CHARGE_MODE_ENERGY) {
+        CHARGE.settings.mode = CHARGE_MODE_CHARGE;
+    }
     CHARGE_SaveSettings();
 }
@@ -24,30 +24,107 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "icon.h"
 #include "chart.h"
 
+#define CHART_PACKED  127 // range of packed values
+#define CHART_STEPS  15 // average position between min and max (4 bits)
+
+#define CHART_SHIFT_MAX  8 // 127<<8 still fits in int16_t
+
+typedef struct {
+    int8_t max;
+    int8_t min;
+} CHART_PACKED_t;
+
+typedef struct {
+    uint8_t column, merged, shift;
+    uint16_t phase; // nominal samples merged into the current column
+    int16_t max, min;
+    int32_t total;
+    CHART_PACKED_t buffer[84]; // values >> shift
+    uint8_t avg[42]; // two columns per byte, even ones in the low nibble
+} CHART_LEVEL_t;
+
+/* Samples per column of each speed (at the nominal sample rate) */
+static const __flash uint16_t CHART_COUNT[] = {
+    [CHART_SPEED_1] = 1000,
+    [CHART_SPEED_2] = 500,
+    [CHART_SPEED_3] = 200,
+    [CHART_SPEED_4] = 100,
+    [CHART_SPEED_5] = 50,
+    [CHART_SPEED_6] = 20,
+    [CHART_SPEED_7] = 10,
+    [CHART_SPEED_8] = 5,
+    [CHART_SPEED_9] = 2,
+    [CHART_SPEED_10] = 1,
+};
+
 static struct CHART_struct {
-    uint8_t lock, scale, column, clear;
+    uint8_t lock, column, clear;
+    uint16_t scale;
+    uint8_t zero; // pixels below the zero line
+    uint8_t view; // level shown (0 is the one fed by CHART_Value)
+    CHART_SPEED_t speed; // speed of level 0
     int16_t max, min;
-    uint16_t sample, count;
+    uint16_t sample, count, rate;
     struct {
         int16_t max;
         int16_t avg;
         int16_t min;
     } buffer[84];
+#if CHART_DEPTH>1
+    CHART_LEVEL_t level[CHART_DEPTH-1]; // slower speeds
+#endif
+    uint8_t high, low; // columns with the extrema of the level shown
 } CHART;
 
+static void CHART_ClearLevels(void);
+static void CHART_Merge(int16_t max, int16_t avg, int16_t min);
+#if CHART_DEPTH>1
+static void CHART_Pack(CHART_LEVEL_t* level, int16_t max, int16_t avg, int16_t min);
+static int8_t CHART_Packed(int16_t value, uint8_t shift);
+#endif
+static uint8_t CHART_Latest(void);
+static void CHART_Read(uint8_t column, int16_t* max, int16_t* avg, int16_t* min);
+static void CHART_Track(void);
+static void CHART_Push(uint8_t column);
+static uint8_t CHART_Scan(uint8_t high);
+static int16_t CHART_Extreme(uint8_t column, uint8_t high);
+
 void CHART_Init(void) {
     CHART.lock = 0;
+    CHART.view = 0;
+    CHART.rate = CHART_RATE_NOMINAL;
     CHART_Clear();
 }
 
 void CHART_Clear(void) {
     CHART.column = 0xFF;
     CHART.max = 0;
+    CHART.clear = 1;
     for(uint8_t i=0; i<DISPLAY_WIDTH; i++) {
         CHART.buffer[i].max = 0;
         CHART.buffer[i].avg = 0;
         CHART.buffer[i].min = 0;
     }
+    CHART_ClearLevels();
+    CHART_Track();
+}
+
+static void CHART_ClearLevels(void) {
+#if CHART_DEPTH>1
+    for(uint8_t k=0; k<(CHART_DEPTH-1); k++) {
+        CHART.level[k].column = 0xFF;
+        CHART.level[k].merged = 0;
+        CHART.level[k].shift = 0;
+        CHART.level[k].phase = 0;
+        for(uint8_t i=0; i<DISPLAY_WIDTH; i++) {
+            CHART.level[k].buffer[i].max = 0;
+            CHART.level[k].buffer[i].min = 0;
+        }
+        for(uint8_t i=0; i<(DISPLAY_WIDTH/2); i++) {
+            CHART.level[k].avg[i] = 0;
+        }
+    }
+#endif
 }
 
 uint8_t CHART_Sample(void) {
@@ -63,67 +140,249 @@ uint8_t CHART_Sample(void) {
     return 0;
 }
 
+/* Bars start at the zero line, which is raised above the bottom when the
+ * chart has negative values (then it is drawn dotted) */
 void CHART_Update(void) {
     static uint8_t pattern = DISPLAY_GRAY;
-    int16_t max = INT16_MIN;
-    int16_t min = INT16_MAX;
-    int16_t value;
-    for(uint8_t i=0; i<DISPLAY_WIDTH; i++) {
-        value = CHART.buffer[i].max;
-        if(value>max) { max = value; }
-        value = CHART.buffer[i].min;
-        if(value<min) { min = value; }
-    }
+    const int16_t max = CHART_Extreme(CHART.high, 1);
+    const int16_t min = CHART_Extreme(CHART.low, 0);
     CHART.max = max;
     CHART.min = min;
-    uint8_t scale = (max/CHART_FULL_SCALE)+1;
+    const int16_t top = (max>0) ? max : 0;
+    const int16_t bottom = (min<0) ? min : 0;
+    uint16_t scale = (((uint16_t)top-(uint16_t)bottom)/CHART_FULL_SCALE)+1;
+    uint8_t zero = ((uint16_t)0-(uint16_t)bottom)/scale;
     DISPLAY_CursorPosition(72, 0);
     if(CHART.lock) {
         scale = CHART.scale;
+        zero = CHART.zero;
         DISPLAY_Icon(ICON_LOCK);
     } else {
         CHART.scale = scale;
+        CHART.zero = zero;
         DISPLAY_Icon(ICON_SCALE);
     }
     DISPLAY_CursorPosition(55, 1);
-    printf_P(TEXT_ADC_SCALE, scale);
+    if(scale>999) {
+        printf_P(TEXT_ADC_SCALE_K, scale/1000);
+    } else {
+        printf_P(TEXT_ADC_SCALE, scale);
+    }
+    int16_t value, avg, low;
     for(uint8_t i=0; i<DISPLAY_WIDTH; i++) {
-        DISPLAY_ChartBar((CHART.buffer[i].max/scale), i, pattern);
-        DISPLAY_ChartBar((CHART.buffer[i].avg/scale), i, DISPLAY_BLACK);
+        CHART_Read(i, &value, &avg, &low);
+        value /= scale;
+        avg /= scale;
+        low /= scale;
+        if(value<0) { value = 0; }
+        if(low>0) { low = 0; }
+        DISPLAY_ChartSpan(zero+low, zero+value, i, pattern);
+        if(avg<0) {
+            DISPLAY_ChartSpan(zero+avg, zero, i, DISPLAY_BLACK);
+        } else {
+            DISPLAY_ChartSpan(zero, zero+avg, i, DISPLAY_BLACK);
+        }
+        if(zero&&!(i&1)) {
+            DISPLAY_ChartSpan(zero, zero+1, i, DISPLAY_BLACK);
+        }
         pattern = ~pattern;
     }
     pattern = ~pattern;
 }
 
+static void CHART_Read(uint8_t column, int16_t* max, int16_t* avg, int16_t* min) {
+#if CHART_DEPTH>1
+    if(CHART.view) {
+        const CHART_LEVEL_t* level = &CHART.level[CHART.view-1];
+        const uint8_t shift = level->shift;
+        const int16_t high = level->buffer[column].max;
+        const int16_t low = level->buffer[column].min;
+        uint8_t step = level->avg[column>>1];
+        if(column&1) { step >>= 4; }
+        step &= 0x0F;
+        *max = high<<shift;
+        *avg = (low+((((high-low)*step)+(CHART_STEPS/2))/CHART_STEPS))<<shift;
+        *min = low<<shift;
+        return;
+    }
+#endif
+    *max = CHART.buffer[column].max;
+    *avg = CHART.buffer[column].avg;
+    *min = CHART.buffer[column].min;
+}
+
 void CHART_Value(int16_t max, int16_t avg, int16_t min) {
     uint8_t column = CHART.column;
     CHART.buffer[column].max = max;
     CHART.buffer[column].avg = avg;
     CHART.buffer[column].min = min;
+    CHART.clear = 0;
+    if(!CHART.view) { CHART_Push(column); }
+    CHART_Merge(max, avg, min);
+}
+
+/* Each level above 0 is one speed slower, its columns merge 2 or 5 columns
+ * of the level below (2.5 for 5/2 ratios, alternately 3 and 2 columns) */
+static void CHART_Merge(int16_t max, int16_t avg, int16_t min) {
+#if CHART_DEPTH>1
+    for(uint8_t k=1; (k<CHART_DEPTH)&&(k<=CHART.speed); k++) {
+        CHART_LEVEL_t* level = &CHART.level[k-1];
+        if(!level->merged) {
+            level->max = max;
+            level->min = min;
+            level->total = 0;
+        } else {
+            if(max>level->max) { level->max = max; }
+            if(min<level->min) { level->min = min; }
+        }
+        level->total += avg;
+        level->merged++;
+        level->phase += CHART_COUNT[CHART.speed-k+1];
+        if(level->phase<CHART_COUNT[CHART.speed-k]) { return; }
+        level->phase -= CHART_COUNT[CHART.speed-k];
+        max = level->max;
+        avg = level->total/level->merged;
+        min = level->min;
+        level->merged = 0;
+        CHART_Pack(level, max, avg, min);
+    }
+#endif
+}
+
+#if CHART_DEPTH>1
+
+/* Levels keep 8-bit extrema with a common shift, which is increased (and
+ * the stored columns halved) when a new column does not fit, the average
+ * is kept as its position between them, which halving does not change */
+static void CHART_Pack(CHART_LEVEL_t* level, int16_t max, int16_t avg, int16_t min) {
+    while(level->shift<CHART_SHIFT_MAX) {
+        const int16_t limit = CHART_PACKED<<level->shift;
+        if((max<=limit)&&(min>=(-limit))) { break; }
+        level->shift++;
+        for(uint8_t i=0; i<DISPLAY_WIDTH; i++) {
+            level->buffer[i].max >>= 1;
+            level->buffer[i].min >>= 1;
+        }
+    }
+    const uint8_t shift = level->shift;
+    if(++level->column>=DISPLAY_WIDTH) { level->column = 0; }
+    const uint8_t column = level->column;
+    level->buffer[column].max = CHART_Packed(max, shift);
+    level->buffer[column].min = CHART_Packed(min, shift);
+    const uint16_t span = (uint16_t)max-(uint16_t)min;
+    uint8_t step = 0;
+    if(avg>=max) {
+        step = CHART_STEPS;
+    } else if(avg>min) {
+        step = ((((uint32_t)((uint16_t)avg-(uint16_t)min))*CHART_STEPS)+(span/2))/span;
+    }
+    uint8_t* nibbles = &level->avg[column>>1];
+    if(column&1) {
+        *nibbles = (*nibbles&0x0F)|(step<<4);
+    } else {
+        *nibbles = (*nibbles&0xF0)|step;
+    }
+    if(CHART.view&&(level==&CHART.level[CHART.view-1])) {
+        CHART_Push(column); // halving kept the order of the values
+    }
+}
+
+static int8_t CHART_Packed(int16_t value, uint8_t shift) {
+    value >>= shift;
+    if(value>CHART_PACKED) { return CHART_PACKED; }
+    if(value<(-CHART_PACKED)) { return -CHART_PACKED; }
+    return value;
+}
+#endif
+
+/* Only the columns with the extrema of the level shown are kept, a new
+ * column replaces one it reaches, all columns are scanned again only when
+ * the column with an extremum is overwritten */
+static void CHART_Push(uint8_t column) {
+    if(column==CHART.high) {
+        CHART.high = CHART_Scan(1);
+    } else if(CHART_Extreme(column, 1)>=CHART_Extreme(CHART.high, 1)) {
+        CHART.high = column;
+    }
+    if(column==CHART.low) {
+        CHART.low = CHART_Scan(0);
+    } else if(CHART_Extreme(column, 0)<=CHART_Extreme(CHART.low, 0)) {
+        CHART.low = column;
+    }
+}
+
+static uint8_t CHART_Scan(uint8_t high) {
+    uint8_t found = 0;
+    int16_t extreme = CHART_Extreme(0, high);
+    for(uint8_t i=1; i<DISPLAY_WIDTH; i++) {
+        const int16_t value = CHART_Extreme(i, high);
+        if(high ? (value>=extreme) : (value<=extreme)) {
+            extreme = value;
+            found = i;
+        }
+    }
+    return found;
+}
+
+static int16_t CHART_Extreme(uint8_t column, uint8_t high) {
+    int16_t max, avg, min;
+    CHART_Read(column, &max, &avg, &min);
+    return high ? max : min;
+}
+
+/* Extrema are searched again when the level shown changes */
+static void CHART_Track(void) {
+    CHART.high = CHART_Scan(1);
+    CHART.low = CHART_Scan(0);
+}
+
+/* Newest column of the level shown */
+static uint8_t CHART_Latest(void) {
+#if CHART_DEPTH>1
+    if(CHART.view) { return CHART.level[CHART.view-1].column; }
+#endif
+    return CHART.column;
 }
 
 void CHART_Marker(void) {
-    DISPLAY_ClearBar(CHART.column);
+    DISPLAY_ClearBar(CHART_Latest());
 }
 
+/* Speed one of the levels has (the same or up to CHART_DEPTH-1 slower than
+ * the level 0 speed) is only shown from that level, so the samples per
+ * column do not change and the chart keeps its history, any other speed
+ * (or a cleared chart) becomes the new level 0 speed */
 uint16_t  CHART_Count(CHART_SPEED_t speed) {
-    static const __flash uint16_t COUNT[] = {
-        [CHART_SPEED_1] = 1000,
-        [CHART_SPEED_2] = 500,
-        [CHART_SPEED_3] = 200,
-        [CHART_SPEED_4] = 100,
-        [CHART_SPEED_5] = 50,
-        [CHART_SPEED_6] = 20,
-        [CHART_SPEED_7] = 10,
-        [CHART_SPEED_8] = 5,
-        [CHART_SPEED_9] = 2,
-        [CHART_SPEED_10] = 1,
-    };
-    CHART.count = COUNT[speed];
+    if(CHART.clear||!CHART_Zoom(speed)) {
+        CHART_ClearLevels();
+        CHART.speed = speed;
+        CHART.view = 0;
+        CHART_Track();
+        /* Samples per column are scaled with the real sample rate, so a
+         * speed keeps its time per column, the fastest one still draws
+         * every sample */
+        uint32_t count = (((uint32_t)CHART_COUNT[speed]*CHART.rate)+(CHART_RATE_NOMINAL/2))>>8;
+        if((speed==CHART_SPEED_10)||(!count)) { count = 1; }
+        CHART.count = count;
+    }
     CHART.sample = 0;
     return CHART.count;
 }
 
+/* Shows a level without new samples (held chart) */
+uint8_t CHART_Zoom(CHART_SPEED_t speed) {
+    if((speed>CHART.speed)||((CHART.speed-speed)>=CHART_DEPTH)) { return 0; }
+    if(CHART.view!=(CHART.speed-speed)) {
+        CHART.view = CHART.speed-speed;
+        CHART_Track();
+    }
+    return 1;
+}
+
+void CHART_Rate(uint16_t rate) {
+    CHART.rate = rate;
+}
+
 uint8_t CHART_Column(void) {
     return CHART.column;
 }
@@ -136,6 +395,10 @@ int16_t CHART_Min(void) {
     return CHART.min;
 }
 
+uint16_t CHART_Scale(void) {
+    return CHART.scale;
+}
+
 void CHART_Lock(void) {
     CHART.lock = !CHART.lock;
 }
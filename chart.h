@@ -17,6 +17,10 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #define CHART_H_INCLUDED
 
 #define CHART_FULL_SCALE  39
+#define CHART_RATE_NOMINAL  256 // Q8 sample rate relative to the nominal one
+#ifndef CHART_DEPTH
+#define CHART_DEPTH  1 // levels kept for zooming out, 223 bytes of RAM each above the first
+#endif
 
 typedef enum {
     CHART_SPEED_1,
@@ -38,9 +42,12 @@ void CHART_Update(void);
 void CHART_Value(int16_t max, int16_t avg, int16_t min);
 void CHART_Marker(void);
 uint16_t CHART_Count(CHART_SPEED_t speed);
+uint8_t CHART_Zoom(CHART_SPEED_t speed);
+void CHART_Rate(uint16_t rate);
 uint8_t CHART_Column(void);
 int16_t CHART_Max(void);
 int16_t CHART_Min(void);
+uint16_t CHART_Scale(void);
 void CHART_Lock(void);
 
 #endif // CHART_H_INCLUDED
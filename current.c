@@ -24,7 +24,7 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "buffer.h"
 #include "current.h"
 
-static ANALOG_SETTINGS_t CURRENT_settings EEMEM;
+ANALOG_SETTINGS_t CURRENT_settings EEMEM;
 
 static void CURRENT_Result(int16_t value) {
     value += 1; //round to closest integer
@@ -42,8 +42,7 @@ static void CURRENT_Result(int16_t value) {
 void CURRENT_Setup(void) {
     ADCA.CH0.CTRL = ADC_CH_GAIN_1X_gc|ADC_CH_INPUTMODE_DIFFWGAINH_gc;
     ADCA.CH0.MUXCTRL = ADC_CH_MUXPOS_PIN7_gc|ADC_CH_MUXNEGH_PIN6_gc;
-    ADCA.CH0.AVGCTRL = (3<<ADC_CH_RIGHTSHIFT_gp)|ADC_SAMPNUM_8X_gc; // 12-bit mode (signed)
-    ANALOG_Init(&CURRENT_settings);
+    ANALOG_Init(&CURRENT_settings, 12); // 12-bit mode (signed)
     ANALOG_Result(CURRENT_Result);
 }
 
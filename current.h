@@ -16,6 +16,10 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #ifndef CURRENT_H_INCLUDED
 #define CURRENT_H_INCLUDED
 
+#include "analog.h"
+
+extern ANALOG_SETTINGS_t CURRENT_settings;
+
 void CURRENT_Init(void);
 void CURRENT_Setup(void);
 void CURRENT_Intro(void);
@@ -132,6 +132,18 @@ void DIGITAL_PrintHex(uint8_t hex) {
     DIGITAL_PrintChar(hex);
 }
 
+void DIGITAL_PrintWord(uint32_t word, uint8_t digits) {
+    if(DIGITAL.column && ((DIGITAL.column+digits)>14)) {
+        DIGITAL.end_line = 1; // do not split word between lines
+    }
+    for(uint8_t i=digits; i>0; i--) {
+        DIGITAL_PrintHex(word>>((i-1)*4));
+    }
+    if((digits>2)&&(DIGITAL.column<14)) {
+        DIGITAL_PrintChar(' ');
+    }
+}
+
 void DIGITAL_PrintTab(void) {
     uint8_t tab_length = 3-(DIGITAL.column%3);
     if((DIGITAL.column+tab_length)>14) { return; }
@@ -207,6 +219,10 @@ void DIGITAL_Hold(uint8_t hold) {
     }
 }
 
+void DIGITAL_Resume(void) {
+    MAIN_Loop(DIGITAL_Loop);
+}
+
 uint8_t DIGITAL_IsHold(void) {
     return DIGITAL.hold;
 }
@@ -29,6 +29,7 @@ void DIGITAL_Print(uint8_t data);
 void DIGITAL_PrintChar(uint8_t ch);
 void DIGITAL_PrintSymbol(uint8_t sym);
 void DIGITAL_PrintHex(uint8_t hex);
+void DIGITAL_PrintWord(uint32_t word, uint8_t digits);
 void DIGITAL_PrintTab(void);
 void DIGITAL_EndLine(void);
 void DIGITAL_InvertLine(void);
@@ -38,6 +39,7 @@ uint8_t DIGITAL_Lock(void);
 void DIGITAL_Hold(uint8_t hold);
 uint8_t DIGITAL_IsHold(void);
 void DIGITAL_Update(void);
+void DIGITAL_Resume(void);
 
 static inline void DIGITAL_CheckClockPeriod(void) {
     TCC5.CTRLB = TC45_BYTEM_NORMAL_gc|TC45_WGMODE_NORMAL_gc;
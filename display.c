@@ -215,6 +215,22 @@ void DISPLAY_ChartBar(int16_t value, uint8_t column, uint8_t pattern) {
     }
 }
 
+/* Pixels from..to-1 above the bottom (like DISPLAY_ChartBar from 0..value-1) */
+void DISPLAY_ChartSpan(int16_t from, int16_t to, uint8_t column, uint8_t pattern) {
+    if(from<0) { from = 0; }
+    if(to>39) { to = 39; }
+    if((from>=to)||(column>=DISPLAY_WIDTH)) { return; }
+    uint8_t* frame = DISPLAY.frame+(column*6);
+    const uint8_t top = (DISPLAY_HEIGHT-1)-(to-1); // rows, bit 7 is the lowest
+    const uint8_t bottom = (DISPLAY_HEIGHT-1)-from;
+    for(uint8_t row=(top>>3); row<=(bottom>>3); row++) {
+        uint8_t mask = 0xFF;
+        if(row==(top>>3)) { mask &= 0xFF<<(top&0x07); }
+        if(row==(bottom>>3)) { mask &= 0xFF>>(7-(bottom&0x07)); }
+        frame[row] |= pattern&mask;
+    }
+}
+
 void DISPLAY_ClearBar(uint8_t column) {
     if(column>=DISPLAY_WIDTH) { return; }
     uint8_t* frame = DISPLAY.frame;
@@ -53,6 +53,7 @@ void DISPLAY_SelectLine(void);
 void DISPLAY_Select(uint8_t top);
 void DISPLAY_ProgressBar(uint8_t length);
 void DISPLAY_ChartBar(int16_t value, uint8_t column, uint8_t pattern);
+void DISPLAY_ChartSpan(int16_t from, int16_t to, uint8_t column, uint8_t pattern);
 void DISPLAY_ClearBar(uint8_t column);
 void DISPLAY_Image(const __flash uint8_t* image);
 void DISPLAY_Icon(const __flash uint8_t* icon);
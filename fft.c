@@ -0,0 +1,126 @@
+/***************************************************************************
+Copyright (c) 2019, Mateusz Panuś
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ***************************************************************************/
+#include <avr/io.h>
+#include "fft.h"
+
+#define FFT_QUARTER  (FFT_SIZE_MAX/4)
+
+/* sin(2*pi*k/FFT_SIZE_MAX) in Q15 for the first quarter, the rest of the
+ * twiddle factors and the window come from symmetry */
+static const __flash int16_t FFT_SIN[FFT_QUARTER+1] = {
+    0, 402, 804, 1206, 1608, 2009, 2411, 2811,
+    3212, 3612, 4011, 4410, 4808, 5205, 5602, 5998,
+    6393, 6787, 7180, 7571, 7962, 8351, 8740, 9127,
+    9512, 9896, 10279, 10660, 11039, 11417, 11793, 12167,
+    12540, 12910, 13279, 13646, 14010, 14373, 14733, 15091,
+    15447, 15800, 16151, 16500, 16846, 17190, 17531, 17869,
+    18205, 18538, 18868, 19195, 19520, 19841, 20160, 20475,
+    20788, 21097, 21403, 21706, 22006, 22302, 22595, 22884,
+    23170, 23453, 23732, 24008, 24279, 24548, 24812, 25073,
+    25330, 25583, 25833, 26078, 26320, 26557, 26791, 27020,
+    27246, 27467, 27684, 27897, 28106, 28311, 28511, 28707,
+    28899, 29086, 29269, 29448, 29622, 29792, 29957, 30118,
+    30274, 30425, 30572, 30715, 30853, 30986, 31114, 31238,
+    31357, 31471, 31581, 31686, 31786, 31881, 31972, 32058,
+    32138, 32214, 32286, 32352, 32413, 32470, 32522, 32568,
+    32610, 32647, 32679, 32706, 32729, 32746, 32758, 32766,
+    32767,
+};
+
+static int16_t FFT_Sin(uint16_t k);
+static int16_t FFT_Cos(uint16_t k);
+
+/* Real samples data[0..size-1] are replaced by complex interleaved
+ * (re, im) Hann windowed samples with the mean removed */
+void FFT_Window(int16_t* data, uint16_t size) {
+    int32_t sum = 0;
+    for(uint16_t i=0; i<size; i++) {
+        sum += data[i];
+    }
+    const int16_t mean = sum/size;
+    const uint16_t step = FFT_SIZE_MAX/size;
+    uint16_t i = size;
+    while(i--) { // from the end, complex sample i does not overwrite real ones <i
+        const int32_t window = (32768L-FFT_Cos(i*step))>>1;
+        const int16_t value = data[i]-mean;
+        data[(2*i)+1] = 0;
+        data[2*i] = (value*window)>>15;
+    }
+}
+
+void FFT_Reverse(int16_t* data, uint16_t size) {
+    uint16_t j = 0;
+    for(uint16_t i=1; i<size; i++) {
+        uint16_t bit = size>>1;
+        while(j&bit) {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+        if(i<j) {
+            int16_t swap = data[2*i];
+            data[2*i] = data[2*j];
+            data[2*j] = swap;
+            swap = data[(2*i)+1];
+            data[(2*i)+1] = data[(2*j)+1];
+            data[(2*j)+1] = swap;
+        }
+    }
+}
+
+/* One radix-2 decimation in time stage (0..log2(size)-1), results are
+ * halved in every stage so the output is DFT/size and cannot overflow */
+void FFT_Stage(int16_t* data, uint16_t size, uint8_t stage) {
+    const uint16_t half = 1<<stage;
+    const uint16_t step = FFT_SIZE_MAX/(2*half);
+    for(uint16_t j=0; j<half; j++) {
+        const int16_t wr = FFT_Cos(j*step);
+        const int16_t wi = -FFT_Sin(j*step);
+        for(uint16_t i=j; i<size; i+=2*half) {
+            int16_t* a = &data[2*i];
+            int16_t* b = &data[2*(i+half)];
+            const int32_t tr = (((int32_t)wr*b[0])-((int32_t)wi*b[1]))>>15;
+            const int32_t ti = (((int32_t)wr*b[1])+((int32_t)wi*b[0]))>>15;
+            b[0] = (a[0]-tr)>>1;
+            b[1] = (a[1]-ti)>>1;
+            a[0] = (a[0]+tr)>>1;
+            a[1] = (a[1]+ti)>>1;
+        }
+    }
+}
+
+/* Alpha max plus beta min (1, 3/8), error below 7% */
+uint16_t FFT_Magnitude(const int16_t* data, uint16_t bin) {
+    uint16_t re = (data[2*bin]<0) ? -data[2*bin] : data[2*bin];
+    uint16_t im = (data[(2*bin)+1]<0) ? -data[(2*bin)+1] : data[(2*bin)+1];
+    if(re<im) {
+        uint16_t swap = re;
+        re = im;
+        im = swap;
+    }
+    return re+(im>>2)+(im>>3);
+}
+
+static int16_t FFT_Sin(uint16_t k) {
+    if(k>FFT_QUARTER) { k = (2*FFT_QUARTER)-k; }
+    return FFT_SIN[k];
+}
+
+static int16_t FFT_Cos(uint16_t k) {
+    if(k>(2*FFT_QUARTER)) { k = (4*FFT_QUARTER)-k; }
+    if(k<=FFT_QUARTER) { return FFT_SIN[FFT_QUARTER-k]; }
+    return -FFT_SIN[k-FFT_QUARTER];
+}
@@ -0,0 +1,26 @@
+/***************************************************************************
+Copyright (c) 2019, Mateusz Panuś
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ***************************************************************************/
+#ifndef FFT_H_INCLUDED
+#define FFT_H_INCLUDED
+
+#define FFT_SIZE_MAX  512
+
+void FFT_Window(int16_t* data, uint16_t size);
+void FFT_Reverse(int16_t* data, uint16_t size);
+void FFT_Stage(int16_t* data, uint16_t size, uint8_t stage);
+uint16_t FFT_Magnitude(const int16_t* data, uint16_t bin);
+
+#endif // FFT_H_INCLUDED
@@ -0,0 +1,156 @@
+/***************************************************************************
+Copyright (c) 2019, Mateusz Panuś
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ***************************************************************************/
+#include <avr/io.h>
+#include "filter.h"
+
+#define FILTER_SHIFT  28 // Q28 notch coefficients
+#define FILTER_FRACTION  4 // fractional bits of the notch state
+#define FILTER_PI  843314857LL // pi in Q28
+
+static struct FILTER_struct {
+    FILTER_MODE_t mode;
+    uint8_t order;
+    uint8_t primed; // state holds the first sample
+    uint8_t index;
+    int32_t sum;
+    union { // only one mode runs at a time
+        int16_t history[1<<FILTER_BOXCAR_ORDER];
+        struct {
+            int32_t k2, d; // allpass coefficients
+            int32_t x1, x2, y1, y2;
+        } notch;
+    };
+} FILTER;
+
+static int32_t FILTER_Cos(int32_t angle);
+static void FILTER_Prime(int16_t sample);
+
+/* Mains notch is (1+A(z))/2 with a second order allpass
+ * A(z) = (k2+d*z^-1+z^-2)/(1+d*z^-1+k2*z^-2), d = -cos(w0)*(1+k2),
+ * its gain is exactly one at DC and zero at w0 */
+void FILTER_Setup(FILTER_MODE_t mode, uint8_t order, uint32_t rate) {
+    FILTER.mode = mode;
+    FILTER.order = order;
+    if((mode==FILTER_MODE_NOTCH50)||(mode==FILTER_MODE_NOTCH60)) {
+        const uint8_t mains = (mode==FILTER_MODE_NOTCH50) ? 50 : 60;
+        if(!FILTER_Usable(mode, rate)) {
+            FILTER.mode = FILTER_MODE_OFF;
+        } else {
+            const int32_t angle = (2*FILTER_PI*mains)/rate;
+            const int64_t k2 = (1LL<<FILTER_SHIFT)-((2*FILTER_PI*FILTER_NOTCH_WIDTH)/rate);
+            FILTER.notch.k2 = k2;
+            FILTER.notch.d = -(((int64_t)FILTER_Cos(angle)*((1LL<<FILTER_SHIFT)+k2))>>FILTER_SHIFT);
+        }
+    }
+    FILTER_Reset();
+}
+
+void FILTER_Reset(void) {
+    FILTER.primed = 0;
+}
+
+/* Taylor series in Q28, the angle is at most pi/2 */
+static int32_t FILTER_Cos(int32_t angle) {
+    const int64_t square = ((int64_t)angle*angle)>>FILTER_SHIFT;
+    int64_t term = 1LL<<FILTER_SHIFT;
+    int64_t sum = term;
+    for(uint8_t n=2; term; n+=2) {
+        term = -((term*square)>>FILTER_SHIFT)/(n*(n-1));
+        sum += term;
+    }
+    return sum;
+}
+
+static void FILTER_Prime(int16_t sample) {
+    FILTER.primed = 1;
+    FILTER.index = 0;
+    FILTER.sum = (int32_t)sample<<FILTER.order;
+    if(FILTER.mode==FILTER_MODE_BOXCAR) {
+        for(uint8_t i=0; i<(1<<FILTER_BOXCAR_ORDER); i++) {
+            FILTER.history[i] = sample;
+        }
+    } else {
+        const int32_t state = (int32_t)sample<<FILTER_FRACTION; // keeps coefficients
+        FILTER.notch.x1 = state;
+        FILTER.notch.x2 = state;
+        FILTER.notch.y1 = state;
+        FILTER.notch.y2 = state;
+    }
+}
+
+/* Integer only, the notch needs two 32x32 bit multiplications per sample
+ * done by the 64-bit library routine (see FILTER_NOTCH_RATE_MAX) */
+int16_t FILTER_Sample(int16_t sample) {
+    if(!FILTER.primed) { FILTER_Prime(sample); }
+    const uint8_t order = FILTER.order;
+    switch(FILTER.mode) {
+    case FILTER_MODE_BOXCAR: {
+        const uint8_t mask = (1<<order)-1;
+        FILTER.sum += sample-FILTER.history[FILTER.index];
+        FILTER.history[FILTER.index] = sample;
+        FILTER.index = (FILTER.index+1)&mask;
+        return (FILTER.sum+(1<<(order-1)))>>order;
+    }
+    case FILTER_MODE_IIR:
+        FILTER.sum += sample-((FILTER.sum+(1<<(order-1)))>>order);
+        return (FILTER.sum+(1<<(order-1)))>>order;
+    case FILTER_MODE_NOTCH50:
+    case FILTER_MODE_NOTCH60: {
+        const int32_t x = (int32_t)sample<<FILTER_FRACTION;
+        int64_t acc = (int64_t)FILTER.notch.k2*(x-FILTER.notch.y2);
+        acc += (int64_t)FILTER.notch.d*(FILTER.notch.x1-FILTER.notch.y1);
+        acc += 1L<<(FILTER_SHIFT-1);
+        const int32_t y = (acc>>FILTER_SHIFT)+FILTER.notch.x2;
+        FILTER.notch.x2 = FILTER.notch.x1;
+        FILTER.notch.x1 = x;
+        FILTER.notch.y2 = FILTER.notch.y1;
+        FILTER.notch.y1 = y;
+        int32_t result = (x+y+(1<<FILTER_FRACTION))>>(FILTER_FRACTION+1);
+        if(result>INT16_MAX) { result = INT16_MAX; }
+        if(result<INT16_MIN) { result = INT16_MIN; }
+        return result;
+    }
+    default:
+        return sample;
+    }
+}
+
+uint8_t FILTER_OrderMax(FILTER_MODE_t mode) {
+    switch(mode) {
+    case FILTER_MODE_BOXCAR: return FILTER_BOXCAR_ORDER;
+    case FILTER_MODE_IIR: return FILTER_IIR_ORDER;
+    default: return 1;
+    }
+}
+
+/* Notch is off when w0 is above pi/2 (the sample rate is too low for it)
+ * or when the CPU can not keep up with the sample rate */
+uint8_t FILTER_Usable(FILTER_MODE_t mode, uint32_t rate) {
+    switch(mode) {
+    case FILTER_MODE_NOTCH50: return (rate>=(4UL*50))&&(rate<=FILTER_NOTCH_RATE_MAX);
+    case FILTER_MODE_NOTCH60: return (rate>=(4UL*60))&&(rate<=FILTER_NOTCH_RATE_MAX);
+    default: return 1;
+    }
+}
+
+/* -3dB frequency: 0.443*rate/N for the boxcar, rate/(2*pi*N) for the IIR */
+uint32_t FILTER_Cutoff(FILTER_MODE_t mode, uint8_t order, uint32_t rate) {
+    switch(mode) {
+    case FILTER_MODE_BOXCAR: return ((rate*443)/1000)>>order;
+    case FILTER_MODE_IIR: return ((rate*159)/1000)>>order;
+    default: return rate/2;
+    }
+}
@@ -0,0 +1,39 @@
+/***************************************************************************
+Copyright (c) 2019, Mateusz Panuś
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ***************************************************************************/
+#ifndef FILTER_H_INCLUDED
+#define FILTER_H_INCLUDED
+
+#define FILTER_BOXCAR_ORDER  5 // up to 32 samples
+#define FILTER_IIR_ORDER  10 // time constant up to 1024 samples
+#define FILTER_NOTCH_WIDTH  4 // Hz
+#define FILTER_NOTCH_RATE_MAX  20000 // Hz, 64-bit products cost about 800 cycles per sample
+
+typedef enum {
+    FILTER_MODE_OFF,
+    FILTER_MODE_BOXCAR,
+    FILTER_MODE_IIR,
+    FILTER_MODE_NOTCH50,
+    FILTER_MODE_NOTCH60,
+} FILTER_MODE_t;
+
+void FILTER_Setup(FILTER_MODE_t mode, uint8_t order, uint32_t rate);
+void FILTER_Reset(void);
+int16_t FILTER_Sample(int16_t sample);
+uint8_t FILTER_OrderMax(FILTER_MODE_t mode);
+uint8_t FILTER_Usable(FILTER_MODE_t mode, uint32_t rate);
+uint32_t FILTER_Cutoff(FILTER_MODE_t mode, uint8_t order, uint32_t rate);
+
+#endif // FILTER_H_INCLUDED
@@ -119,4 +119,5 @@ const __flash uint8_t FONT[][5] = {
     { 0x40, 0x00, 0x40, 0x00, 0x40 },   // overflow
     { 0x7f, 0x41, 0x55, 0x55, 0x7f },   // error
     { 0x7f, 0x7f, 0x7f, 0x7f, 0x7f },   // black box
+    { 0x7f, 0x41, 0x55, 0x6b, 0x7f },   // break
 };
@@ -22,6 +22,7 @@ typedef enum {
     FONT_SYMBOL_OVERFLOW = 130,
     FONT_SYMBOL_ERROR = 131,
     FONT_SYMBOL_BLACK_BOX = 132,
+    FONT_SYMBOL_BREAK = 133,
 } FONT_SYMBOL_t;
 
 extern const __flash uint8_t FONT[][5];
@@ -23,6 +23,7 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "text.h"
 #include "buffer.h"
 #include "image.h"
+#include "icon.h"
 #include "display.h"
 #include "analog.h"
 #include "delay.h"
@@ -277,8 +278,14 @@ static void FREQ_Hold(void) {
 }
 
 void FREQ_Intro(void) {
+    static const __flash uint8_t* const __flash FREQ_ICONS[] = {
+        ICON_SLOWER,
+        ICON_FASTER,
+        ICON_HOLD_RUN,
+        ICON_LOCK,
+    };
     DISPLAY_Image(IMAGE_FREQ);
-    DISPLAY_Icons(ANALOG_ICONS);
+    DISPLAY_Icons(FREQ_ICONS);
     DISPLAY_Send();
 }
 
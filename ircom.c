@@ -15,6 +15,7 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ***************************************************************************/
 #include <avr/io.h>
 #include <avr/eeprom.h>
+#include "avr/iox32e5.h"
 #include "avr/eeprom.h"
 #include "main.h"
 #include "text.h"
@@ -34,28 +35,121 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
     #undef IRCOM
 #endif // IRCOM
 
+#define IRCOM_US(us)        ((us)/2) // TCC5 tick is 2us (DIV64)
+#define IRCOM_GAP           IRCOM_US(8000) // end of remote control frame
+#define IRCOM_REPEAT        IRCOM_US(120000) // same frame within is a repeat
+#define IRCOM_UNITS         64 // Manchester half-bits (RC5: 28, RC6: 44)
+
 typedef enum {
     IRCOM_INVERT_NO,
     IRCOM_INVERT_YES
 } IRCOM_INVERT_t;
 
+typedef enum {
+    IRCOM_MODE_IRDA,
+    IRCOM_MODE_REMOTE
+} IRCOM_MODE_t;
+
+typedef enum {
+    IRCOM_PROTOCOL_NONE,
+    IRCOM_PROTOCOL_NEC,
+    IRCOM_PROTOCOL_REPEAT,
+    IRCOM_PROTOCOL_SIRC,
+    IRCOM_PROTOCOL_RC5,
+    IRCOM_PROTOCOL_RC6,
+    IRCOM_PROTOCOL_ERROR
+} IRCOM_PROTOCOL_t;
+
+typedef enum {
+    IRCOM_NEC_MARK,
+    IRCOM_NEC_SPACE,
+    IRCOM_NEC_REPEAT,
+    IRCOM_NEC_BIT,
+    IRCOM_NEC_ONE,
+    IRCOM_SIRC_MARK,
+    IRCOM_SIRC_BIT,
+    IRCOM_SIRC_ONE,
+    IRCOM_RC6_MARK,
+    IRCOM_RC6_SPACE,
+    IRCOM_RC5_T1,
+    IRCOM_RC5_T2,
+    IRCOM_RC6_T1,
+    IRCOM_RC6_T2,
+    IRCOM_RC6_T3,
+    IRCOM_PULSES
+} IRCOM_PULSE_t;
+
+typedef struct {
+    uint16_t min;
+    uint16_t max;
+} IRCOM_WINDOW_t;
+
+/* Pulse width windows (mark or space), demodulated receiver output */
+static const __flash IRCOM_WINDOW_t IRCOM_WINDOW[IRCOM_PULSES] = {
+    [IRCOM_NEC_MARK]    = {IRCOM_US(7000), IRCOM_US(11000)}, // 9000us
+    [IRCOM_NEC_SPACE]   = {IRCOM_US(3500), IRCOM_US(5500)}, // 4500us
+    [IRCOM_NEC_REPEAT]  = {IRCOM_US(1750), IRCOM_US(2750)}, // 2250us
+    [IRCOM_NEC_BIT]     = {IRCOM_US(300), IRCOM_US(850)}, // 560us
+    [IRCOM_NEC_ONE]     = {IRCOM_US(1200), IRCOM_US(2200)}, // 1690us
+    [IRCOM_SIRC_MARK]   = {IRCOM_US(2000), IRCOM_US(2550)}, // 2400us
+    [IRCOM_SIRC_BIT]    = {IRCOM_US(350), IRCOM_US(900)}, // 600us
+    [IRCOM_SIRC_ONE]    = {IRCOM_US(900), IRCOM_US(1500)}, // 1200us
+    [IRCOM_RC6_MARK]    = {IRCOM_US(2550), IRCOM_US(3300)}, // 2666us
+    [IRCOM_RC6_SPACE]   = {IRCOM_US(650), IRCOM_US(1150)}, // 889us
+    [IRCOM_RC5_T1]      = {IRCOM_US(445), IRCOM_US(1333)}, // 889us
+    [IRCOM_RC5_T2]      = {IRCOM_US(1333), IRCOM_US(2222)}, // 1778us
+    [IRCOM_RC6_T1]      = {IRCOM_US(222), IRCOM_US(666)}, // 444us
+    [IRCOM_RC6_T2]      = {IRCOM_US(666), IRCOM_US(1111)}, // 889us
+    [IRCOM_RC6_T3]      = {IRCOM_US(1111), IRCOM_US(1555)}, // 1333us
+};
+
 typedef struct {
     USART_BAUD_t baud;
     USART_PARITY_t parity;
     DIGITAL_DISPLAY_t display;
     IRCOM_INVERT_t invert;
+    uint32_t custom;
+    IRCOM_MODE_t mode;
 } IRCOM_SETTINGS_t;
 
 static IRCOM_SETTINGS_t IRCOM_settings EEMEM;
 static struct {
+    uint16_t ctrl;
     IRCOM_SETTINGS_t settings;
+    struct {
+        IRCOM_PROTOCOL_t protocol;
+        uint8_t frame;  // edges received since idle line
+        uint8_t mark;   // current pulse is a mark (IR carrier on)
+        uint8_t phase;  // leader space received
+        uint8_t stop;   // NEC stop mark received
+        uint8_t count;  // bits (NEC, SIRC) or half-bits (RC5, RC6)
+        uint8_t repeat; // previous frame is recent
+        uint16_t last;
+        uint32_t code;
+        uint32_t previous;
+        uint8_t units[IRCOM_UNITS/8];
+    } remote;
 } IRCOM;
 
 static void IRCOM_Decode(void);
 static void IRCOM_KeyUp(KEYPAD_KEY_t key);
 static void IRCOM_Setup(USART_t* const usart);
+static void IRCOM_Start(void);
+static void IRCOM_RemoteStart(void);
+static void IRCOM_RemoteDecode(void);
+static void IRCOM_RemotePulse(uint16_t pulse);
+static void IRCOM_RemoteNEC(uint16_t pulse);
+static void IRCOM_RemoteSIRC(uint16_t pulse);
+static uint8_t IRCOM_Units(uint16_t pulse, IRCOM_PULSE_t type, uint8_t max);
+static void IRCOM_RemoteUnits(uint8_t units);
+static uint8_t IRCOM_RemoteUnit(uint8_t unit);
+static void IRCOM_RemoteEnd(void);
+static uint8_t IRCOM_RemoteManchester(uint8_t unit, uint8_t bits);
+static void IRCOM_RemotePrint(const __flash char* name, uint16_t address, uint8_t command);
 static void IRCOM_SettingsLoop(void);
 static void IRCOM_SettingsKeyUp(KEYPAD_KEY_t key);
+static void IRCOM_SettingsExit(void);
+static void IRCOM_BaudCtrl(void);
 static inline void IRCOM_SaveSettings(void);
 static inline void IRCOM_LoadSettings(void);
 
@@ -66,16 +160,21 @@ void IRCOM_Init(void) {
     UART_Desc();
     DIGITAL_Init(IRCOM_Decode);
     DIGITAL_Display(IRCOM.settings.display);
-    BUFFER_Init(BUFFER_MODE_USART_RX);
     KEYPAD_KeyUp(IRCOM_KeyUp);
     PORTC_REMAP = PORT_USART0_bm;
-    IRCOM_Setup(&USARTC0);
+    IRCOM_Start();
 }
 
 static void IRCOM_Decode(void) {
+    if(IRCOM.settings.mode==IRCOM_MODE_REMOTE) {
+        IRCOM_RemoteDecode();
+        return;
+    }
     while(!BUFFER_Empty()) {
         uint8_t status = BUFFER_GetData();
         if(status&USART_RXCIF_bm) {
+            BUFFER_GetData(); // time (not used)
+            BUFFER_GetData();
             uint8_t data = BUFFER_GetData();
             if(status&(USART_FERR_bm|USART_PERR_bm)) {
                 data = FONT_SYMBOL_PERR;
@@ -119,7 +218,7 @@ static void IRCOM_Setup(USART_t* const usart) {
     } else {
         PORTC_PIN6CTRL = PORT_OPC_BUSKEEPER_gc|PORT_INVEN_bm;
     }
-    USART_SetBaudAsync(usart, USART_Baud(IRCOM.settings.baud));
+    USART_SetBaudCtrl(usart, IRCOM.ctrl);
     (usart)->STATUS = 0xFF;
     USART_PMODE_t PMODE_gc = USART_PMODE(IRCOM.settings.parity);
     (usart)->CTRLC = USART_CMODE_IRDA_gc|PMODE_gc|USART_CHSIZE_8BIT_gc;
@@ -127,12 +226,336 @@ static void IRCOM_Setup(USART_t* const usart) {
     (usart)->CTRLB = USART_RXEN_bm;
 }
 
+static void IRCOM_Start(void) {
+    BUFFER_Stop();
+    if(IRCOM.settings.mode==IRCOM_MODE_REMOTE) {
+        USARTC0.CTRLB = 0;
+        IRCOM_RemoteStart();
+        return;
+    }
+    TCC5.CTRLA = TC45_CLKSEL_OFF_gc;
+    EVSYS.CH6MUX = EVSYS_CHMUX_OFF_gc;
+    BUFFER_Init(BUFFER_MODE_USART_RX);
+    IRCOM_Setup(&USARTC0);
+}
+
+static void IRCOM_RemoteStart(void) {
+    IRCOM.remote.frame = 0;
+    IRCOM.remote.repeat = 0;
+    BUFFER_Init(BUFFER_MODE_TCC5_CNT);
+    PORTC_PIN6CTRL = PORT_OPC_BUSKEEPER_gc|PORT_ISC_BOTHEDGES_gc; // RX
+    EVSYS.CH0MUX = EVSYS_CHMUX_OFF_gc; // LUT0 IN1
+    EVSYS.CH6MUX = EVSYS_CHMUX_PORTC_PIN6_gc; // LUT0 IN0
+    EVSYS.CH2MUX = EVSYS_CHMUX_XCL_LUT0_gc; // Buffer EDMA trigger
+    /* LUT0(EVSYS.CH2) = (EVSYS.CH6) OR (EVSYS.CH0) */
+    XCL.CTRLA = XCL_LUTOUTEN_DISABLE_gc|XCL_PORTSEL_PC_gc|XCL_LUTCONF_2LUT2IN_gc;
+    XCL.CTRLB = XCL_IN3SEL_EVSYS_gc|XCL_IN2SEL_EVSYS_gc|XCL_IN1SEL_EVSYS_gc|XCL_IN0SEL_EVSYS_gc;
+    XCL.CTRLC = XCL_DLY1CONF_NO_gc|XCL_DLY0CONF_NO_gc;
+    XCL.CTRLD = (0x0<<XCL_TRUTH1_gp)|(0xE<<XCL_TRUTH0_gp);
+    /* Timer TCC5 (2us) is used to timestamp (with EDMA) every receiver edge */
+    TCC5.CTRLB = TC45_BYTEM_NORMAL_gc|TC45_WGMODE_NORMAL_gc;
+    TCC5.CTRLD = TC45_EVACT_OFF_gc|TC45_EVSEL_OFF_gc;
+    TCC5.CTRLA = TC45_CLKSEL_DIV64_gc;
+    BUFFER_Clear();
+}
+
+static void IRCOM_RemoteDecode(void) {
+    while(!BUFFER_Empty()) {
+        uint16_t time = (uint16_t)BUFFER_GetSample();
+        uint16_t pulse = time-IRCOM.remote.last;
+        IRCOM.remote.last = time;
+        if(IRCOM.remote.frame&&!IRCOM.remote.mark&&(pulse>=IRCOM_GAP)) {
+            IRCOM_RemoteEnd(); // idle line was not noticed in time
+        }
+        if(!IRCOM.remote.frame) { // first edge after idle line starts a mark
+            IRCOM.remote.frame = 1;
+            IRCOM.remote.mark = 1;
+            IRCOM.remote.protocol = IRCOM_PROTOCOL_NONE;
+            continue;
+        }
+        IRCOM_RemotePulse(pulse);
+        IRCOM.remote.mark = !IRCOM.remote.mark;
+    }
+    uint16_t idle = TCC5_CNT-IRCOM.remote.last;
+    if(IRCOM.remote.frame) {
+        if(!IRCOM.remote.mark&&(idle>=IRCOM_GAP)) {
+            IRCOM_RemoteEnd();
+        }
+    } else if(idle>=IRCOM_REPEAT) {
+        IRCOM.remote.repeat = 0;
+    }
+}
+
+static inline uint8_t IRCOM_Is(uint16_t pulse, IRCOM_PULSE_t type) {
+    return (pulse>=IRCOM_WINDOW[type].min)&&(pulse<IRCOM_WINDOW[type].max);
+}
+
+static uint8_t IRCOM_Units(uint16_t pulse, IRCOM_PULSE_t type, uint8_t max) {
+    for(uint8_t units=1; units<=max; units++, type++) {
+        if(IRCOM_Is(pulse, type)) {
+            return units;
+        }
+    }
+    return 0;
+}
+
+static void IRCOM_RemotePulse(uint16_t pulse) {
+    switch(IRCOM.remote.protocol) {
+        case IRCOM_PROTOCOL_NONE:
+            IRCOM.remote.phase = 0;
+            IRCOM.remote.stop = 0;
+            IRCOM.remote.count = 0;
+            IRCOM.remote.code = 0;
+            for(uint8_t i=0; i<sizeof(IRCOM.remote.units); i++) {
+                IRCOM.remote.units[i] = 0;
+            }
+            if(IRCOM_Is(pulse, IRCOM_NEC_MARK)) {
+                IRCOM.remote.protocol = IRCOM_PROTOCOL_NEC;
+            } else if(IRCOM_Is(pulse, IRCOM_SIRC_MARK)) {
+                IRCOM.remote.protocol = IRCOM_PROTOCOL_SIRC;
+            } else if(IRCOM_Is(pulse, IRCOM_RC6_MARK)) {
+                IRCOM.remote.protocol = IRCOM_PROTOCOL_RC6;
+            } else {
+                IRCOM.remote.protocol = IRCOM_PROTOCOL_RC5;
+                IRCOM.remote.count = 1; // first half of start bit (space)
+                IRCOM_RemoteUnits(IRCOM_Units(pulse, IRCOM_RC5_T1, 2));
+            }
+            break;
+        case IRCOM_PROTOCOL_NEC:
+            IRCOM_RemoteNEC(pulse);
+            break;
+        case IRCOM_PROTOCOL_REPEAT:
+            if(IRCOM.remote.mark&&!IRCOM.remote.stop&&IRCOM_Is(pulse, IRCOM_NEC_BIT)) {
+                IRCOM.remote.stop = 1;
+            } else {
+                IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+            }
+            break;
+        case IRCOM_PROTOCOL_SIRC:
+            IRCOM_RemoteSIRC(pulse);
+            break;
+        case IRCOM_PROTOCOL_RC5:
+            IRCOM_RemoteUnits(IRCOM_Units(pulse, IRCOM_RC5_T1, 2));
+            break;
+        case IRCOM_PROTOCOL_RC6:
+            if(IRCOM.remote.phase) {
+                IRCOM_RemoteUnits(IRCOM_Units(pulse, IRCOM_RC6_T1, 3));
+            } else if(IRCOM_Is(pulse, IRCOM_RC6_SPACE)) {
+                IRCOM.remote.phase = 1;
+            } else {
+                IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+            }
+            break;
+        default: break;
+    }
+}
+
+static void IRCOM_RemoteNEC(uint16_t pulse) {
+    if(!IRCOM.remote.phase) {
+        if(IRCOM_Is(pulse, IRCOM_NEC_SPACE)) {
+            IRCOM.remote.phase = 1;
+        } else if(IRCOM_Is(pulse, IRCOM_NEC_REPEAT)) {
+            IRCOM.remote.protocol = IRCOM_PROTOCOL_REPEAT;
+        } else {
+            IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+        }
+        return;
+    }
+    if(IRCOM.remote.mark) {
+        if(!IRCOM_Is(pulse, IRCOM_NEC_BIT)) {
+            IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+        } else if(IRCOM.remote.count==32) {
+            IRCOM.remote.stop = 1;
+        }
+        return;
+    }
+    if(IRCOM.remote.count>=32) {
+        IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+        return;
+    }
+    IRCOM.remote.code >>= 1; // LSB first
+    if(IRCOM_Is(pulse, IRCOM_NEC_ONE)) {
+        IRCOM.remote.code |= 0x80000000;
+    } else if(!IRCOM_Is(pulse, IRCOM_NEC_BIT)) {
+        IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+    }
+    IRCOM.remote.count++;
+}
+
+static void IRCOM_RemoteSIRC(uint16_t pulse) {
+    if(!IRCOM.remote.mark) {
+        IRCOM.remote.phase = 1;
+        if(!IRCOM_Is(pulse, IRCOM_SIRC_BIT)) {
+            IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+        }
+        return;
+    }
+    if(IRCOM.remote.count>=20) {
+        IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+        return;
+    }
+    if(IRCOM_Is(pulse, IRCOM_SIRC_ONE)) { // LSB first
+        IRCOM.remote.code |= ((uint32_t)1<<IRCOM.remote.count);
+    } else if(!IRCOM_Is(pulse, IRCOM_SIRC_BIT)) {
+        IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+    }
+    IRCOM.remote.count++;
+}
+
+static void IRCOM_RemoteUnits(uint8_t units) {
+    if(!units) {
+        IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+        return;
+    }
+    for(; units>0; units--) {
+        const uint8_t count = IRCOM.remote.count;
+        if(count>=IRCOM_UNITS) {
+            IRCOM.remote.protocol = IRCOM_PROTOCOL_ERROR;
+            return;
+        }
+        if(IRCOM.remote.mark) {
+            IRCOM.remote.units[count>>3] |= (1<<(count&7));
+        }
+        IRCOM.remote.count = count+1;
+    }
+}
+
+static uint8_t IRCOM_RemoteUnit(uint8_t unit) {
+    return (IRCOM.remote.units[unit>>3]>>(unit&7))&1;
+}
+
+/* Decodes Manchester bits (MSB first) to code, bit value is the first half */
+static uint8_t IRCOM_RemoteManchester(uint8_t unit, uint8_t bits) {
+    for(; bits>0; bits--, unit+=2) {
+        const uint8_t half = IRCOM_RemoteUnit(unit);
+        if(half==IRCOM_RemoteUnit(unit+1)) {
+            return 0;
+        }
+        IRCOM.remote.code = (IRCOM.remote.code<<1)|half;
+    }
+    return 1;
+}
+
+static void IRCOM_RemoteEnd(void) {
+    const IRCOM_PROTOCOL_t protocol = IRCOM.remote.protocol;
+    const uint32_t code = IRCOM.remote.code;
+    const uint8_t count = IRCOM.remote.count;
+    IRCOM.remote.frame = 0;
+    IRCOM.remote.code = 0;
+    if((protocol==IRCOM_PROTOCOL_RC5)||(protocol==IRCOM_PROTOCOL_RC6)) {
+        if(count&1) {
+            IRCOM.remote.count = count+1; // last half-bit (space) merged with idle line
+        }
+    }
+    switch(protocol) {
+        case IRCOM_PROTOCOL_NONE:
+            return;
+        case IRCOM_PROTOCOL_NEC: {
+            const uint8_t command = code>>16;
+            uint16_t address = code&0xFFFF;
+            if((count!=32)||!IRCOM.remote.stop||((command^(code>>24))&0xFF)!=0xFF) {
+                break;
+            }
+            if(((address^(address>>8))&0xFF)==0xFF) {
+                address &= 0xFF; // standard NEC, extended NEC has 16-bit address
+            }
+            IRCOM.remote.repeat = 0;
+            IRCOM.remote.code = code;
+            IRCOM_RemotePrint(TEXT_IR_NEC, address, command);
+            return;
+        }
+        case IRCOM_PROTOCOL_REPEAT:
+            if(!IRCOM.remote.stop) {
+                break;
+            }
+            DIGITAL_PrintChar('+');
+            return;
+        case IRCOM_PROTOCOL_SIRC:
+            if((count!=12)&&(count!=15)&&(count!=20)) {
+                break;
+            }
+            IRCOM.remote.code = ((uint32_t)count<<24)|code;
+            IRCOM_RemotePrint(TEXT_IR_SIRC, code>>7, code&0x7F);
+            return;
+        case IRCOM_PROTOCOL_RC5:
+            /* S1 S2 T A4..A0 C5..C0, logic one is space-mark */
+            if((IRCOM.remote.count!=28)||!IRCOM_RemoteManchester(0, 14)) {
+                break;
+            }
+            IRCOM.remote.code ^= 0x3FFF;
+            if(!(IRCOM.remote.code&0x2000)) {
+                break;
+            }
+            IRCOM_RemotePrint(TEXT_IR_RC5, (IRCOM.remote.code>>6)&0x1F,
+                ((IRCOM.remote.code&0x3F)|((~IRCOM.remote.code>>6)&0x40)));
+            return;
+        case IRCOM_PROTOCOL_RC6: {
+            /* 1 M2..M0 T(2T) A7..A0 C7..C0, logic one is mark-space */
+            if((IRCOM.remote.count!=44)||!IRCOM_RemoteManchester(0, 4)) {
+                break;
+            }
+            if(IRCOM.remote.code!=0x8) {
+                break; // start bit or mode other than 0
+            }
+            const uint8_t toggle = IRCOM_RemoteUnit(8); // double width trailer bit
+            if((toggle!=IRCOM_RemoteUnit(9))||(toggle==IRCOM_RemoteUnit(10))||(toggle==IRCOM_RemoteUnit(11))) {
+                break;
+            }
+            IRCOM.remote.code = (IRCOM.remote.code<<1)|toggle;
+            if(!IRCOM_RemoteManchester(12, 16)) {
+                break;
+            }
+            IRCOM_RemotePrint(TEXT_IR_RC6, (IRCOM.remote.code>>8)&0xFF, IRCOM.remote.code&0xFF);
+            return;
+        }
+        default: break;
+    }
+    IRCOM.remote.repeat = 0;
+    DIGITAL_EndLine();
+    DIGITAL_PrintSymbol(FONT_SYMBOL_ERROR);
+}
+
+static void IRCOM_RemotePrint(const __flash char* name, uint16_t address, uint8_t command) {
+    const uint32_t code = IRCOM.remote.code;
+    if(IRCOM.remote.repeat&&(IRCOM.remote.previous==code)) {
+        DIGITAL_PrintChar('+'); // same frame (also RC5/RC6 toggle bit)
+        return;
+    }
+    IRCOM.remote.previous = code;
+    IRCOM.remote.repeat = 1;
+    DIGITAL_EndLine();
+    for(; *name; name++) {
+        DIGITAL_PrintChar(*name);
+    }
+    if(address>0xFF) {
+        DIGITAL_PrintWord(address>>8, 2);
+    }
+    DIGITAL_PrintWord(address, 2);
+    DIGITAL_PrintChar(':');
+    DIGITAL_PrintWord(command, 2);
+}
+
+static inline uint32_t IRCOM_Baud(void) {
+    if(IRCOM.settings.baud==USART_BAUD_CUSTOM) {
+        return IRCOM.settings.custom;
+    }
+    return USART_Baud(IRCOM.settings.baud);
+}
+
+static void IRCOM_BaudCtrl(void) {
+    IRCOM.ctrl = USART_BaudAsync(IRCOM_Baud());
+}
+
 static void IRCOM_SettingsLoop(void) {
     if(!DISPLAY_Update()) { return; }
     DISPLAY_CursorPosition(0, 1);
     puts_P(TEXT_IRCOM_SETTINGS);
     DISPLAY_CursorPosition(6,15);
-    printf_P(TEXT_BAUD, USART_Baud(IRCOM.settings.baud));
+    if(IRCOM.settings.mode==IRCOM_MODE_REMOTE) {
+        puts_P(TEXT_IR_REMOTE);
+    } else {
+        printf_P(TEXT_BAUD, IRCOM_Baud());
+    }
     DISPLAY_CursorPosition(6,24);
     printf_P(TEXT_PARITY, USART_Parity(IRCOM.settings.parity));
     DISPLAY_CursorPosition(6,33);
@@ -143,6 +566,12 @@ static void IRCOM_SettingsLoop(void) {
     } else {
         puts_P(TEXT_YES);
     }
+    DISPLAY_CursorPosition(6,41);
+    if(IRCOM.settings.mode==IRCOM_MODE_REMOTE) {
+        puts_P(TEXT_IR_PROTOCOLS);
+    } else {
+        USART_PrintRate(IRCOM.ctrl, IRCOM_Baud());
+    }
     DISPLAY_InvertLine(0);
     DISPLAY_SelectLine();
 }
@@ -150,9 +579,15 @@ static void IRCOM_SettingsLoop(void) {
 static void IRCOM_SettingsKeyUp(KEYPAD_KEY_t key) {
     switch(key) {
         case KEYPAD_KEY1:
-            if((IRCOM.settings.baud++)==USART_BAUD_2000000) {
+            if(IRCOM.settings.mode==IRCOM_MODE_REMOTE) {
+                IRCOM.settings.mode = IRCOM_MODE_IRDA;
                 IRCOM.settings.baud = USART_BAUD_1200;
+            } else if(IRCOM.settings.baud==USART_BAUD_CUSTOM) {
+                IRCOM.settings.mode = IRCOM_MODE_REMOTE;
+            } else {
+                IRCOM.settings.baud++;
             }
+            IRCOM_BaudCtrl();
             DISPLAY_Select(14);
             break;
         case KEYPAD_KEY2:
@@ -166,17 +601,26 @@ static void IRCOM_SettingsKeyUp(KEYPAD_KEY_t key) {
             DISPLAY_Select(32);
             break;
         case KEYPAD_KEY4:
-            IRCOM_SaveSettings();
-            IRCOM_Setup(&USARTC0);
-            KEYPAD_KeyUp(IRCOM_KeyUp);
-            DIGITAL_Init(IRCOM_Decode);
-            DIGITAL_Display(IRCOM.settings.display);
-            DIGITAL_Hold(0);
+            if((IRCOM.settings.mode==IRCOM_MODE_IRDA)&&(IRCOM.settings.baud==USART_BAUD_CUSTOM)) {
+                USART_Custom(&IRCOM.settings.custom, IRCOM_SettingsExit);
+            } else {
+                IRCOM_SettingsExit();
+            }
             break;
         default: break;
     }
 }
 
+static void IRCOM_SettingsExit(void) {
+    IRCOM_SaveSettings();
+    IRCOM_BaudCtrl();
+    IRCOM_Start();
+    KEYPAD_KeyUp(IRCOM_KeyUp);
+    DIGITAL_Init(IRCOM_Decode);
+    DIGITAL_Display(IRCOM.settings.display);
+    DIGITAL_Hold(0);
+}
+
 void IRCOM_Intro(void) {
     DISPLAY_Image(IMAGE_IRCOM);
     DISPLAY_Icons(USART_ICONS);
@@ -189,7 +633,7 @@ static inline void IRCOM_SaveSettings(void) {
 
 static inline void IRCOM_LoadSettings(void) {
     eeprom_read_block(&IRCOM.settings, &IRCOM_settings, sizeof(IRCOM_SETTINGS_t));
-    if(IRCOM.settings.baud>USART_BAUD_2000000) {
+    if(IRCOM.settings.baud>USART_BAUD_CUSTOM) {
         IRCOM.settings.baud = USART_BAUD_9600;
     }
     if(IRCOM.settings.parity>USART_PARITY_EVEN) {
@@ -201,5 +645,13 @@ static inline void IRCOM_LoadSettings(void) {
     if(IRCOM.settings.invert>IRCOM_INVERT_YES) {
         IRCOM.settings.invert = IRCOM_INVERT_YES;
     }
+    uint32_t custom = IRCOM.settings.custom;
+    if((custom<USART_CUSTOM_MIN)||(custom>USART_CUSTOM_MAX)) {
+        IRCOM.settings.custom = USART_CUSTOM_DEF;
+    }
+    if(IRCOM.settings.mode>IRCOM_MODE_REMOTE) {
+        IRCOM.settings.mode = IRCOM_MODE_IRDA;
+    }
     IRCOM_SaveSettings();
+    IRCOM_BaudCtrl();
 }
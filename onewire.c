@@ -20,6 +20,7 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "main.h"
 #include "text.h"
 #include "avr/eeprom.h"
+#include "font.h"
 #include "image.h"
 #include "icon.h"
 #include "buffer.h"
@@ -39,6 +40,83 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #define BIT_ONE_MIN  0x001F //   1us -1% (0,99us)
 #define BIT_ONE_MAX  0x01C6 //  14us +1% (14,2us)
 
+/* Overdrive (TCC5 at 32MHz, 31.25ns resolution is enough for 1us slots) */
+#define OD_TIMEOUT      0x1200 // 144us
+#define OD_RESET_MIN    0x05F0 //  48us -1% (47,5us)
+#define OD_RESET_MAX    0x0A20 //  80us +1% (81us)
+#define OD_PRESENCE_MIN 0x00FD //   8us -1% (7,9us)
+#define OD_PRESENCE_MAX 0x030A //  24us +1% (24,3us)
+#define OD_BIT_ZERO_MIN 0x0041 //   2us +1% (2,03us)
+#define OD_BIT_ZERO_MAX 0x0205 //  16us +1% (16,2us)
+#define OD_BIT_ONE_MIN  0x001F //   1us -1% (0,99us)
+#define OD_BIT_ONE_MAX  0x003F //   2us -1% (1,97us)
+
+#define ROM_READ            0x33
+#define ROM_MATCH           0x55
+#define ROM_SKIP            0xCC
+#define ROM_SEARCH          0xF0
+#define ROM_ALARM_SEARCH    0xEC
+#define ROM_RESUME          0xA5
+#define ROM_OVERDRIVE_SKIP  0x3C
+#define ROM_OVERDRIVE_MATCH 0x69
+#define READ_SCRATCHPAD     0xBE
+
+#define ONEWIRE_BINS 8
+
+typedef enum {
+    ONEWIRE_PHASE_COMMAND,
+    ONEWIRE_PHASE_ROM,
+    ONEWIRE_PHASE_SEARCH,
+    ONEWIRE_PHASE_FUNCTION,
+    ONEWIRE_PHASE_SCRATCHPAD,
+    ONEWIRE_PHASE_DATA
+} ONEWIRE_PHASE_t;
+
+typedef enum {
+    ONEWIRE_SPEED_STANDARD,
+    ONEWIRE_SPEED_OVERDRIVE
+} ONEWIRE_SPEED_t;
+
+typedef enum {
+    ONEWIRE_SLOT_RESET,
+    ONEWIRE_SLOT_PRESENCE,
+    ONEWIRE_SLOT_ZERO, // write 0 or read 0
+    ONEWIRE_SLOT_ONE, // write 1 or read 1
+    ONEWIRE_SLOTS
+} ONEWIRE_SLOT_t;
+
+typedef struct {
+    uint16_t min, max;
+} ONEWIRE_WINDOW_t;
+
+typedef struct {
+    uint16_t timeout;
+    ONEWIRE_WINDOW_t window[ONEWIRE_SLOTS];
+} ONEWIRE_TIMING_t;
+
+static const __flash ONEWIRE_TIMING_t ONEWIRE_TIMING[] = {
+    [ONEWIRE_SPEED_STANDARD] = {
+        TIMEOUT, {
+            {RESET_MIN, RESET_MAX}, {PRESENCE_MIN, PRESENCE_MAX},
+            {BIT_ZERO_MIN, BIT_ZERO_MAX}, {BIT_ONE_MIN, BIT_ONE_MAX}
+        }
+    },
+    [ONEWIRE_SPEED_OVERDRIVE] = {
+        OD_TIMEOUT, {
+            {OD_RESET_MIN, OD_RESET_MAX}, {OD_PRESENCE_MIN, OD_PRESENCE_MAX},
+            {OD_BIT_ZERO_MIN, OD_BIT_ZERO_MAX}, {OD_BIT_ONE_MIN, OD_BIT_ONE_MAX}
+        }
+    }
+};
+
+/* Low pulse durations (within window), window is divided into bins
+ * (saturated, only their ratio is shown) */
+typedef struct {
+    uint16_t min, max, count;
+    uint32_t sum;
+    uint8_t bin[ONEWIRE_BINS];
+} ONEWIRE_HISTOGRAM_t;
+
 typedef struct {
     uint8_t tab;
 } ONEWIRE_SETTINGS_t;
@@ -46,10 +124,24 @@ typedef struct {
 static ONEWIRE_SETTINGS_t ONEWIRE_settings EEMEM;
 static struct {
     uint8_t reset;
+    uint8_t bits; // 8 (byte) or 3 (search triplet)
+    ONEWIRE_PHASE_t phase;
+    uint8_t count, crc, rom;
+    ONEWIRE_SPEED_t speed;
+    const __flash ONEWIRE_TIMING_t* timing;
+    uint8_t shift[ONEWIRE_SLOTS];
+    uint8_t page;
+    ONEWIRE_HISTOGRAM_t histogram[ONEWIRE_SLOTS]; // current speed only
     ONEWIRE_SETTINGS_t settings;
 } ONEWIRE;
 
 static void ONEWIRE_Decode(void);
+static void ONEWIRE_Byte(uint8_t byte);
+static void ONEWIRE_Triplet(uint8_t triplet);
+static void ONEWIRE_Check(void);
+static void ONEWIRE_Speed(ONEWIRE_SPEED_t speed);
+static void ONEWIRE_TimingClear(void);
+static void ONEWIRE_TimingLoop(void);
 static void ONEWIRE_KeyUp(KEYPAD_KEY_t key);
 static void ONEWIRE_Info(void);
 static void ONEWIRE_Icons(void);
@@ -67,6 +159,8 @@ void ONEWIRE_Init(void) {
     KEYPAD_KeyUp(ONEWIRE_KeyUp);
     DIGITAL_Init(ONEWIRE_Decode);
     DIGITAL_Display(ONEWIRE.settings.tab);
+    ONEWIRE.phase = ONEWIRE_PHASE_DATA;
+    ONEWIRE.bits = 8;
     BUFFER_Init(BUFFER_MODE_TCC5_CNT);
     EVSYS.CH0MUX = EVSYS_CHMUX_ACA_CH1_gc; // LUT0 IN1
     EVSYS.CH4MUX = EVSYS_CHMUX_ACA_CH0_gc; // Restart TCC5 (timestamp)
@@ -98,17 +192,66 @@ void ONEWIRE_Init(void) {
     TCC5.CTRLB = TC45_BYTEM_NORMAL_gc|TC45_WGMODE_NORMAL_gc;
     TCC5.CTRLD = TC45_EVACT_RESTART_gc|TC45_EVSEL_CH4_gc;
     TCC5.CTRLA = TC45_CLKSEL_DIV1_gc;
+    ONEWIRE_Speed(ONEWIRE_SPEED_STANDARD);
+    ONEWIRE_TimingClear();
+    ONEWIRE.page = 0;
     BUFFER_Clear();
 }
 
+/* Timing thresholds are switched and BTC0 timeout is reprogrammed,
+ * new period is used from next restart (falling edge), histograms of
+ * the previous speed are cleared */
+static void ONEWIRE_Speed(ONEWIRE_SPEED_t speed) {
+    if(ONEWIRE.speed!=speed) {
+        ONEWIRE_TimingClear();
+    }
+    ONEWIRE.speed = speed;
+    ONEWIRE.timing = &ONEWIRE_TIMING[speed];
+    XCL.PERCAPTL = ONEWIRE.timing->timeout>>8;
+    XCL.PERCAPTH = ONEWIRE.timing->timeout>>8;
+    for(uint8_t i=0; i<ONEWIRE_SLOTS; i++) {
+        const __flash ONEWIRE_WINDOW_t* window = &ONEWIRE.timing->window[i];
+        uint16_t width = window->max-window->min;
+        uint8_t shift = 0;
+        while((width>>shift)>=ONEWIRE_BINS) { shift++; }
+        ONEWIRE.shift[i] = shift;
+    }
+}
+
+static inline void ONEWIRE_Slot(ONEWIRE_SLOT_t slot, uint16_t sample) {
+    ONEWIRE_HISTOGRAM_t* histogram = &ONEWIRE.histogram[slot];
+    if(histogram->count==UINT16_MAX) { return; }
+    if(!histogram->count||(sample<histogram->min)) {
+        histogram->min = sample;
+    }
+    if(sample>histogram->max) {
+        histogram->max = sample;
+    }
+    histogram->count++;
+    histogram->sum += sample;
+    uint16_t offset = sample-ONEWIRE.timing->window[slot].min;
+    uint8_t* bin = &histogram->bin[offset>>ONEWIRE.shift[slot]];
+    if(*bin<UINT8_MAX) { (*bin)++; }
+}
+
+static void ONEWIRE_TimingClear(void) {
+    uint8_t* data = (uint8_t*)ONEWIRE.histogram;
+    for(uint16_t i=0; i<sizeof(ONEWIRE.histogram); i++) {
+        data[i] = 0;
+    }
+}
+
 static void ONEWIRE_Decode(void) {
     static uint8_t byte, bit;
+    const __flash ONEWIRE_WINDOW_t* const window = ONEWIRE.timing->window;
     while(!BUFFER_Empty()) {
         uint16_t sample = (uint16_t)BUFFER_GetSample();
         if(ONEWIRE.reset) {
-            if(sample>PRESENCE_MIN && sample<PRESENCE_MAX) {
+            const __flash ONEWIRE_WINDOW_t* presence = &window[ONEWIRE_SLOT_PRESENCE];
+            if(sample>presence->min && sample<presence->max) {
+                ONEWIRE_Slot(ONEWIRE_SLOT_PRESENCE, sample);
                 DIGITAL_PrintChar('+');
-            } else if(sample>TIMEOUT) {
+            } else if(sample>ONEWIRE.timing->timeout) {
                 DIGITAL_PrintChar('-');
             } else {
                 DIGITAL_PrintChar('?');
@@ -116,7 +259,14 @@ static void ONEWIRE_Decode(void) {
             if(ONEWIRE.settings.tab) { DIGITAL_PrintTab(); }
             ONEWIRE.reset = 0;
         } else {
-            if(sample>RESET_MIN && sample<RESET_MAX) {
+            const __flash ONEWIRE_WINDOW_t* reset = &window[ONEWIRE_SLOT_RESET];
+            const __flash ONEWIRE_WINDOW_t* zero = &window[ONEWIRE_SLOT_ZERO];
+            const __flash ONEWIRE_WINDOW_t* one = &window[ONEWIRE_SLOT_ONE];
+            if(ONEWIRE.speed && sample>RESET_MIN && sample<RESET_MAX) {
+                ONEWIRE_Speed(ONEWIRE_SPEED_STANDARD); // standard reset
+            }
+            if(sample>reset->min && sample<reset->max) {
+                ONEWIRE_Slot(ONEWIRE_SLOT_RESET, sample);
                 if(bit>0){
                     if(bit>3) {
                         DIGITAL_PrintHex(byte>>4);
@@ -126,21 +276,30 @@ static void ONEWIRE_Decode(void) {
                 DIGITAL_EndLine();
                 DIGITAL_PrintChar('R');
                 ONEWIRE.reset = 1;
+                ONEWIRE.phase = ONEWIRE_PHASE_COMMAND;
+                ONEWIRE.bits = 8;
                 byte = 0x00;
                 bit = 0;
-            } else if(sample>BIT_ZERO_MIN && sample<BIT_ZERO_MAX) {
+            } else if(sample>zero->min && sample<zero->max) {
+                ONEWIRE_Slot(ONEWIRE_SLOT_ZERO, sample);
                 byte >>= 1;
                 bit++;
-            } else if(sample>BIT_ONE_MIN && sample<BIT_ONE_MAX) {
+            } else if(sample>one->min && sample<one->max) {
+                ONEWIRE_Slot(ONEWIRE_SLOT_ONE, sample);
                 byte >>= 1;
                 byte |= 0x80;
                 bit++;
             }
-            if(bit==8) {
-                DIGITAL_PrintHex(byte>>4);
-                DIGITAL_PrintHex(byte>>0);
-                if(ONEWIRE.settings.tab) {
-                    DIGITAL_PrintTab();
+            if(bit==ONEWIRE.bits) {
+                if(bit==8) {
+                    DIGITAL_PrintHex(byte>>4);
+                    DIGITAL_PrintHex(byte>>0);
+                    if(ONEWIRE.settings.tab) {
+                        DIGITAL_PrintTab();
+                    }
+                    ONEWIRE_Byte(byte);
+                } else {
+                    ONEWIRE_Triplet(byte>>5);
                 }
                 byte = 0x00;
                 bit = 0;
@@ -149,6 +308,124 @@ static void ONEWIRE_Decode(void) {
     }
 }
 
+/* Dallas/Maxim CRC8 (polynomial 0x8C, reflected) */
+static const __flash uint8_t ONEWIRE_CRC8[256] = {
+    0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+    0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E, 0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
+    0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0, 0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
+    0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D, 0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
+    0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5, 0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
+    0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58, 0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
+    0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6, 0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
+    0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B, 0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
+    0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F, 0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
+    0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92, 0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
+    0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C, 0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
+    0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1, 0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
+    0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49, 0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
+    0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4, 0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
+    0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A, 0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
+    0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7, 0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35
+};
+
+static void ONEWIRE_Byte(uint8_t byte) {
+    switch(ONEWIRE.phase) {
+        case ONEWIRE_PHASE_COMMAND:
+            ONEWIRE.count = 0;
+            ONEWIRE.crc = 0;
+            switch(byte) {
+                case ROM_OVERDRIVE_MATCH: // ROM ID is sent at overdrive speed
+                    ONEWIRE_Speed(ONEWIRE_SPEED_OVERDRIVE);
+                    /* fall through */
+                case ROM_READ:
+                case ROM_MATCH:
+                    ONEWIRE.phase = ONEWIRE_PHASE_ROM;
+                    break;
+                case ROM_SKIP:
+                case ROM_RESUME:
+                    ONEWIRE.phase = ONEWIRE_PHASE_FUNCTION;
+                    break;
+                case ROM_OVERDRIVE_SKIP:
+                    ONEWIRE.phase = ONEWIRE_PHASE_FUNCTION;
+                    ONEWIRE_Speed(ONEWIRE_SPEED_OVERDRIVE);
+                    break;
+                case ROM_SEARCH:
+                case ROM_ALARM_SEARCH:
+                    ONEWIRE.phase = ONEWIRE_PHASE_SEARCH;
+                    ONEWIRE.bits = 3;
+                    DIGITAL_EndLine();
+                    break;
+                default:
+                    ONEWIRE.phase = ONEWIRE_PHASE_DATA;
+                    break;
+            }
+            break;
+        case ONEWIRE_PHASE_ROM:
+            ONEWIRE.crc = ONEWIRE_CRC8[ONEWIRE.crc^byte];
+            if(++ONEWIRE.count==8) {
+                ONEWIRE_Check();
+                ONEWIRE.phase = ONEWIRE_PHASE_FUNCTION;
+            }
+            break;
+        case ONEWIRE_PHASE_FUNCTION:
+            ONEWIRE.phase = ONEWIRE_PHASE_DATA;
+            if(byte==READ_SCRATCHPAD) {
+                ONEWIRE.phase = ONEWIRE_PHASE_SCRATCHPAD;
+                ONEWIRE.count = 0;
+                ONEWIRE.crc = 0;
+            }
+            break;
+        case ONEWIRE_PHASE_SCRATCHPAD:
+            ONEWIRE.crc = ONEWIRE_CRC8[ONEWIRE.crc^byte];
+            if(++ONEWIRE.count==9) { // 8 bytes and CRC
+                ONEWIRE_Check();
+                ONEWIRE.phase = ONEWIRE_PHASE_DATA;
+            }
+            break;
+        default: break;
+    }
+}
+
+/* Search ROM: ID bit, complement bit and bit selected by master */
+static void ONEWIRE_Triplet(uint8_t triplet) {
+    uint8_t id = triplet&0x01;
+    uint8_t complement = (triplet>>1)&0x01;
+    uint8_t direction = (triplet>>2)&0x01;
+    if((id&complement)||((id!=complement)&&(direction!=id))) {
+        DIGITAL_PrintChar('?'); // no device (or all deselected)
+        ONEWIRE.phase = ONEWIRE_PHASE_DATA;
+        ONEWIRE.bits = 8;
+        return;
+    }
+    ONEWIRE.rom >>= 1;
+    ONEWIRE.rom |= (direction<<7);
+    if((++ONEWIRE.count&0x07)==0) {
+        uint8_t byte = ONEWIRE.rom;
+        DIGITAL_PrintHex(byte>>4);
+        DIGITAL_PrintHex(byte>>0);
+        if(ONEWIRE.settings.tab) {
+            DIGITAL_PrintTab();
+        }
+        ONEWIRE.crc = ONEWIRE_CRC8[ONEWIRE.crc^byte];
+        if(ONEWIRE.count==64) {
+            ONEWIRE_Check();
+            ONEWIRE.phase = ONEWIRE_PHASE_FUNCTION;
+            ONEWIRE.bits = 8;
+        }
+    }
+}
+
+static void ONEWIRE_Check(void) {
+    if(ONEWIRE.crc) {
+        DIGITAL_PrintSymbol(FONT_SYMBOL_ERROR);
+    } else {
+        DIGITAL_PrintChar('=');
+        if(ONEWIRE.settings.tab) {
+            DIGITAL_PrintTab();
+        }
+    }
+}
+
 static void ONEWIRE_KeyUp(KEYPAD_KEY_t key) {
     if(DIGITAL_Lock()&&(key!=KEYPAD_KEY1)) {
         return;
@@ -160,21 +437,79 @@ static void ONEWIRE_KeyUp(KEYPAD_KEY_t key) {
             MAIN_Loop(ONEWIRE_InfoLoop);
             break;
         case KEYPAD_KEY2:
-            if(DIGITAL_IsHold()) { return; }
+            if(DIGITAL_IsHold()) {
+                /* Slot timing pages (of the current speed) */
+                if((++ONEWIRE.page)>ONEWIRE_SLOTS) {
+                    ONEWIRE.page = 0;
+                    DIGITAL_Resume();
+                } else {
+                    MAIN_Loop(ONEWIRE_TimingLoop);
+                }
+                return;
+            }
             ONEWIRE.settings.tab = !ONEWIRE.settings.tab;
             DIGITAL_Display(ONEWIRE.settings.tab);
             ONEWIRE_SaveSettings();
             break;
         case KEYPAD_KEY3:
+            if(ONEWIRE.page) {
+                ONEWIRE.page = 0;
+                DIGITAL_Resume();
+            }
             DIGITAL_Hold(!DIGITAL_IsHold());
             break;
         case KEYPAD_KEY4:
+            ONEWIRE_TimingClear();
             DIGITAL_Clear();
             break;
         default: break;
     }
 }
 
+static void ONEWIRE_PrintTime(const __flash char* text, uint16_t ticks) {
+    uint16_t time = ((uint32_t)ticks*5)>>4; // 0.1us
+    printf_P(text, time/10, time%10);
+}
+
+/* Min/avg/max of low pulses, histogram bars span the whole datasheet window */
+static void ONEWIRE_TimingLoop(void) {
+    static const __flash char* const __flash SLOT[] = {
+        [ONEWIRE_SLOT_RESET] = TEXT_SLOT_RESET,
+        [ONEWIRE_SLOT_PRESENCE] = TEXT_SLOT_PRESENCE,
+        [ONEWIRE_SLOT_ZERO] = TEXT_SLOT_ZERO,
+        [ONEWIRE_SLOT_ONE] = TEXT_SLOT_ONE,
+    };
+    if(!DISPLAY_Update()) { return; }
+    uint8_t slot = ONEWIRE.page-1;
+    ONEWIRE_HISTOGRAM_t* histogram = &ONEWIRE.histogram[slot];
+    DISPLAY_CursorPosition(1, 1);
+    if(ONEWIRE.speed==ONEWIRE_SPEED_OVERDRIVE) {
+        puts_P(TEXT_SLOT_OD);
+    }
+    printf_P(TEXT_SLOT, SLOT[slot], histogram->count);
+    DISPLAY_InvertLine(0);
+    if(histogram->count) {
+        DISPLAY_CursorPosition(4, 10);
+        ONEWIRE_PrintTime(TEXT_SLOT_MIN, histogram->min);
+        DISPLAY_CursorPosition(4, 19);
+        ONEWIRE_PrintTime(TEXT_SLOT_AVG, histogram->sum/histogram->count);
+        DISPLAY_CursorPosition(4, 28);
+        ONEWIRE_PrintTime(TEXT_SLOT_MAX, histogram->max);
+        uint8_t peak = 1;
+        for(uint8_t i=0; i<ONEWIRE_BINS; i++) {
+            if(histogram->bin[i]>peak) { peak = histogram->bin[i]; }
+        }
+        for(uint8_t i=0; i<ONEWIRE_BINS; i++) {
+            uint8_t bin = histogram->bin[i];
+            uint8_t bar = ((uint16_t)bin*10)/peak;
+            if(bin&&!bar) { bar = 1; }
+            for(uint8_t x=0; x<9; x++) {
+                DISPLAY_ChartBar(bar, 2+(i*10)+x, DISPLAY_BLACK);
+            }
+        }
+    }
+}
+
 static void ONEWIRE_InfoLoop(void) {
     if(!DISPLAY_Update()) { return; }
     DISPLAY_CursorPosition(9, 1);
@@ -190,6 +525,7 @@ static void ONEWIRE_InfoLoop(void) {
 
 static void ONEWIRE_InfoKeyUp(KEYPAD_KEY_t key) {
     (void)key; //unused
+    ONEWIRE.page = 0;
     DIGITAL_Init(ONEWIRE_Decode);
     DIGITAL_Display(ONEWIRE.settings.tab);
     KEYPAD_KeyUp(ONEWIRE_KeyUp);
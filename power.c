@@ -0,0 +1,327 @@
+/***************************************************************************
+Copyright (c) 2019, Mateusz Panuś
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ***************************************************************************/
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+#include <stdio.h>
+#include "avr/eeprom.h"
+#include "main.h"
+#include "text.h"
+#include "keypad.h"
+#include "buffer.h"
+#include "display.h"
+#include "analog.h"
+#include "voltage.h"
+#include "current.h"
+#include "chart.h"
+#include "power.h"
+
+#define POWER_SHIFT  7 // product of 14-bit samples >> 7 = 16uW (1mV * 0.125mA)
+#define POWER_UW  16
+#define CHART_SHIFT  6 // 16uW << 6 = 1.024mW per chart unit
+
+typedef enum {
+    POWER_READOUT_POWER,
+    POWER_READOUT_VOLTAGE,
+    POWER_READOUT_CURRENT,
+    POWER_READOUT_SKEW,
+} POWER_READOUT_t;
+
+typedef enum {
+    POWER_CHANNEL_VOLTAGE,
+    POWER_CHANNEL_CURRENT,
+} POWER_CHANNEL_t;
+
+typedef struct {
+    CHART_SPEED_t speed;
+    POWER_READOUT_t readout;
+} POWER_SETTINGS_t;
+
+static POWER_SETTINGS_t POWER_settings EEMEM;
+static struct POWER_struct {
+    volatile POWER_CHANNEL_t next;
+    uint8_t hold;
+    int16_t voltage, current; // last samples of both channels
+    int16_t max, min;
+    uint16_t count;
+    int32_t total;
+    struct {
+        uint16_t count;
+        int32_t voltage, current;
+        int64_t power;
+    } sum;
+    struct {
+        int16_t voltage, current;
+        int32_t power;
+    } result;
+    struct {
+        uint8_t ctrl, muxctrl;
+        int16_t offset;
+        uint16_t gain;
+    } channel[POWER_CHANNEL_CURRENT+1];
+    POWER_SETTINGS_t settings;
+} POWER;
+
+static void POWER_Interrupt(void);
+static void POWER_Flush(void);
+static void POWER_Loop(void);
+static void POWER_Result(void);
+static void POWER_Print(void);
+static void POWER_KeyUp(KEYPAD_KEY_t key);
+static inline void POWER_ChangeCount(void);
+static inline void POWER_SaveSettings(void);
+static inline void POWER_LoadSettings(void);
+
+void POWER_Init(void) {
+    POWER_LoadSettings();
+    POWER_Setup();
+    MAIN_Loop(POWER_Flush);
+    KEYPAD_KeyUp(POWER_KeyUp);
+    POWER.hold = 0;
+}
+
+/* Voltage (PIN8/PIN5) and current (PIN7/PIN6) are converted alternately,
+ * the conversion rate and averaging are the ones of the VOLTAGE mode */
+void POWER_Setup(void) {
+    POWER.channel[POWER_CHANNEL_VOLTAGE].ctrl = ADC_CH_GAIN_DIV2_gc|ADC_CH_INPUTMODE_DIFFWGAINH_gc;
+    POWER.channel[POWER_CHANNEL_VOLTAGE].muxctrl = ADC_CH_MUXPOS_PIN8_gc|ADC_CH_MUXNEGH_PIN5_gc;
+    ANALOG_Correction(&VOLTAGE_settings, &POWER.channel[POWER_CHANNEL_VOLTAGE].offset, &POWER.channel[POWER_CHANNEL_VOLTAGE].gain);
+    POWER.channel[POWER_CHANNEL_CURRENT].ctrl = ADC_CH_GAIN_1X_gc|ADC_CH_INPUTMODE_DIFFWGAINH_gc;
+    ANALOG_Correction(&CURRENT_settings, &POWER.channel[POWER_CHANNEL_CURRENT].offset, &POWER.channel[POWER_CHANNEL_CURRENT].gain);
+    POWER_Offset(0);
+    ADCA.CH0.CTRL = POWER.channel[POWER_CHANNEL_VOLTAGE].ctrl;
+    ADCA.CH0.MUXCTRL = POWER.channel[POWER_CHANNEL_VOLTAGE].muxctrl;
+    ANALOG_Init(&VOLTAGE_settings, 14); // 14-bit mode (signed) for both channels
+    CHART_Rate(((ANALOG_Rate()<<7)+(ANALOG_RATE_NOMINAL/2))/ANALOG_RATE_NOMINAL); // pairs
+    POWER_Start();
+}
+
+/* Conversions are started one by one from the interrupt, which switches the
+ * channel, EDMA still stores results: even samples are voltage, odd current.
+ * Called again whenever results were skipped (EVSYS off) to align BUFFER */
+void POWER_Start(void) {
+    EVSYS_CH2MUX = EVSYS_CHMUX_OFF_gc;
+    XCL_INTCTRL = XCL_UNF_INTLVL_OFF_gc; // conversions are not restarted by BTC0
+    XCL_CTRLE = XCL_CLKSEL_OFF_gc;
+    XCL_INTFLAGS = XCL_UNF0IF_bm;
+    ADCA.CTRLB = ADC_CURRLIMIT_NO_gc|ADC_CONMODE_bm|ADC_RESOLUTION_MT12BIT_gc;
+    ADCA.CTRLA |= ADC_FLUSH_bm;
+    ANALOG_Interrupt(POWER_Interrupt);
+    BUFFER_Init(BUFFER_MODE_ADCA_RES);
+    POWER.voltage = 0;
+    POWER.current = 0;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        POWER.next = POWER_CHANNEL_VOLTAGE;
+        EVSYS_CH2MUX = EVSYS_CHMUX_ADCA_CH0_gc;
+        ADCA.CH0.INTFLAGS = ADC_CH_IF_bm;
+        ADCA.CH0.INTCTRL = ADC_CH_INTMODE_COMPLETE_gc|ADC_CH_INTLVL_LO_gc;
+        POWER_Interrupt();
+    }
+}
+
+/* Current input is shorted (PIN6/PIN6) for offset calibration */
+void POWER_Offset(uint8_t offset) {
+    if(offset) {
+        POWER.channel[POWER_CHANNEL_CURRENT].muxctrl = ADC_CH_MUXPOS_PIN6_gc|ADC_CH_MUXNEGH_PIN6_gc;
+    } else {
+        POWER.channel[POWER_CHANNEL_CURRENT].muxctrl = ADC_CH_MUXPOS_PIN7_gc|ADC_CH_MUXNEGH_PIN6_gc;
+    }
+}
+
+/* Current is converted half way between two voltage conversions, mean of
+ * them compensates the skew of one conversion period */
+uint8_t POWER_Sample(POWER_PAIR_t* pair) {
+    const uint8_t odd = BUFFER.first&sizeof(int16_t);
+    int16_t sample = BUFFER_GetSample();
+    if(odd) {
+        POWER.current = sample;
+        return 0;
+    }
+    pair->voltage = (POWER.voltage+sample)>>1;
+    pair->current = POWER.current;
+    POWER.voltage = sample;
+    return 1;
+}
+
+static void POWER_Interrupt(void) {
+    const POWER_CHANNEL_t next = POWER.next;
+    const uint16_t offset = POWER.channel[next].offset;
+    const uint16_t gain = POWER.channel[next].gain;
+    ADCA.CH0.MUXCTRL = POWER.channel[next].muxctrl;
+    ADCA.CH0.OFFSETCORR0 = 0xFF&(offset>>0);
+    ADCA.CH0.OFFSETCORR1 = 0x0F&(offset>>8);
+    ADCA.CH0.GAINCORR0 = 0xFF&(gain>>0);
+    ADCA.CH0.GAINCORR1 = 0x0F&(gain>>8);
+    ADCA.CH0.CTRL = POWER.channel[next].ctrl|ADC_CH_START_bm;
+    POWER.next = (next==POWER_CHANNEL_VOLTAGE) ? POWER_CHANNEL_CURRENT : POWER_CHANNEL_VOLTAGE;
+}
+
+static void POWER_Flush(void) {
+    if(BUFFER_Flush()) {
+        POWER.max = INT16_MIN;
+        POWER.min = INT16_MAX;
+        POWER.sum.count = 0;
+        POWER.sum.voltage = 0;
+        POWER.sum.current = 0;
+        POWER.sum.power = 0;
+        POWER.result.voltage = 0;
+        POWER.result.current = 0;
+        POWER.result.power = 0;
+        POWER_ChangeCount();
+        MAIN_Loop(POWER_Loop);
+    }
+}
+
+static void POWER_Loop(void) {
+    POWER_PAIR_t pair;
+    while(!BUFFER_Empty()) {
+        if(!POWER_Sample(&pair)||POWER.hold) { continue; }
+        const int32_t power = ((int32_t)pair.voltage*pair.current)>>POWER_SHIFT;
+        POWER.sum.count++;
+        POWER.sum.voltage += pair.voltage;
+        POWER.sum.current += pair.current;
+        POWER.sum.power += power;
+        const int16_t value = power>>CHART_SHIFT;
+        if(value>POWER.max) { POWER.max = value; }
+        if(value<POWER.min) { POWER.min = value; }
+        POWER.total += value;
+        if(CHART_Sample()) {
+            CHART_Value(POWER.max, POWER.total/POWER.count, POWER.min);
+            POWER.total = 0;
+            POWER.max = INT16_MIN;
+            POWER.min = INT16_MAX;
+        }
+    }
+    if(ANALOG_Refresh()&&!POWER.hold) {
+        POWER_Result();
+    }
+    if(DISPLAY_Update()){
+        CHART_Update();
+        DISPLAY_CursorPosition(8,1);
+        POWER_Print();
+        if(POWER.hold) { DISPLAY_InvertLine(0); }
+        if(POWER.settings.speed<=CHART_SPEED_4) {
+            CHART_Marker();
+        }
+    }
+}
+
+static void POWER_Result(void) {
+    const uint16_t count = POWER.sum.count;
+    if(!count) { return; }
+    POWER.result.voltage = POWER.sum.voltage/count;
+    POWER.result.current = POWER.sum.current/count;
+    POWER.result.power = POWER.sum.power/count;
+    POWER.sum.count = 0;
+    POWER.sum.voltage = 0;
+    POWER.sum.current = 0;
+    POWER.sum.power = 0;
+}
+
+static void POWER_Print(void) {
+    switch(POWER.settings.readout) {
+    case POWER_READOUT_VOLTAGE: {
+        int16_t value = (POWER.result.voltage+5)/10; //round to closest integer
+        const char sign = (value<0) ? '-' : ' ';
+        if(value<0) { value = -value; }
+        printf_P(TEXT_VOLTAGE_VALUE, sign, (int)(value/100), (int)(value%100));
+        DISPLAY_MoveCursor(2);
+        puts_P(TEXT_VOLTAGE_UNIT);
+        break;
+    }
+    case POWER_READOUT_CURRENT:
+        printf_P(TEXT_CURRENT_VALUE, (POWER.result.current+4)/8); // 0.125mA
+        DISPLAY_MoveCursor(2);
+        puts_P(TEXT_CURRENT_UNIT);
+        break;
+    case POWER_READOUT_SKEW:
+        printf_P(TEXT_POWER_SKEW, 1000000/ANALOG_Rate());
+        DISPLAY_MoveCursor(2);
+        puts_P(TEXT_POWER_US);
+        DISPLAY_CursorPosition(55, 1); // instead of chart scale
+        puts_P(TEXT_POWER_SKW);
+        break;
+    default: {
+        int32_t value = POWER.result.power*POWER_UW;
+        const char sign = (value<0) ? '-' : ' ';
+        if(value<0) { value = -value; }
+        const uint16_t watt = value/1000000;
+        if(watt<10) {
+            printf_P(TEXT_POWER_VALUE, sign, watt, (uint16_t)((value/1000)%1000));
+        } else {
+            printf_P(TEXT_OVERLOAD, sign);
+            DISPLAY_MoveCursor(6);
+        }
+        DISPLAY_MoveCursor(2);
+        puts_P(TEXT_POWER_UNIT);
+        break;
+    }
+    }
+}
+
+static void POWER_KeyUp(KEYPAD_KEY_t key) {
+    if(POWER.hold && key!=KEYPAD_KEY3) { return; }
+    switch(key) {
+    case KEYPAD_KEY1:
+        if(POWER.settings.speed>CHART_SPEED_1) {
+            POWER.settings.speed--;
+            POWER_ChangeCount();
+            POWER_SaveSettings();
+        }
+        break;
+    case KEYPAD_KEY2:
+        if(POWER.settings.speed<CHART_SPEED_10) {
+            POWER.settings.speed++;
+            POWER_ChangeCount();
+            POWER_SaveSettings();
+        }
+        break;
+    case KEYPAD_KEY3:
+        POWER.hold = !POWER.hold;
+        break;
+    case KEYPAD_KEY4:
+        if((POWER.settings.readout++)==POWER_READOUT_SKEW) {
+            POWER.settings.readout = POWER_READOUT_POWER;
+        }
+        POWER_SaveSettings();
+        break;
+    case KEYPAD_KEY34:
+        CHART_Lock();
+        break;
+    default:
+        break;
+    }
+}
+
+static inline void POWER_ChangeCount(void) {
+    POWER.count = CHART_Count(POWER.settings.speed);
+    POWER.total = 0;
+}
+
+static inline void POWER_SaveSettings(void) {
+    EEPROM_update_block(&POWER.settings, &POWER_settings, sizeof(POWER_SETTINGS_t));
+}
+
+static inline void POWER_LoadSettings(void) {
+    eeprom_read_block(&POWER.settings, &POWER_settings, sizeof(POWER_SETTINGS_t));
+    if(POWER.settings.speed>CHART_SPEED_10) {
+        POWER.settings.speed = CHART_SPEED_1;
+    }
+    if(POWER.settings.readout>POWER_READOUT_SKEW) {
+        POWER.settings.readout = POWER_READOUT_POWER;
+    }
+    POWER_SaveSettings();
+}
@@ -0,0 +1,30 @@
+/***************************************************************************
+Copyright (c) 2019, Mateusz Panuś
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ***************************************************************************/
+#ifndef POWER_H_INCLUDED
+#define POWER_H_INCLUDED
+
+typedef struct {
+    int16_t voltage; // 1mV
+    int16_t current; // 0.125mA
+} POWER_PAIR_t;
+
+void POWER_Init(void);
+void POWER_Setup(void);
+void POWER_Start(void);
+void POWER_Offset(uint8_t offset);
+uint8_t POWER_Sample(POWER_PAIR_t* pair);
+
+#endif // POWER_H_INCLUDED
@@ -35,7 +35,12 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #define SPI_SCK_bm  PIN1_bm
 #define SPI_START '<'
 #define SPI_STOP  '>'
-#define SPI_MIN_CLOCK_PERIOD 28 //<1us (1MHz)
+#define SPI_MIN_CLOCK_PERIOD 28 //<1us (1MHz), every SCK edge is one EDMA sample
+#define SPI_WIDTH_MIN  4
+#define SPI_WIDTH_DEF  8
+#define SPI_WIDTH_MAX  32
+#define SPI_DETECT_FRAMES  16
+#define SPI_DETECT_EDGES  16384
 
 typedef enum {
     SPI_INPUT_MOSI,
@@ -57,32 +62,65 @@ typedef enum {
     SPI_SELECT_HIGH
 } SPI_SELECT_t;
 
+typedef enum {
+    SPI_LINE_DATA,
+    SPI_LINE_CLOCK,
+    SPI_LINE_SELECT,
+    SPI_LINE_WIDTH,
+    SPI_LINE_AUTO
+} SPI_LINE_t;
+
 typedef struct {
     SPI_INPUT_t input;
     SPI_DATA_t data;
     SPI_CLOCK_t clock;
     SPI_SELECT_t select;
+    uint8_t width;
 } SPI_SETTINGS_t;
 
 static SPI_SETTINGS_t SPI_settings EEMEM;
 static struct {
     uint8_t input, select;
+    uint8_t byte, size, chunk, left;
+    uint32_t word;
+    SPI_LINE_t line;
+    struct {
+        uint8_t prev, valid, count;
+        uint8_t byte[2][2]; // [edge][order]
+        uint16_t edges, total;
+        uint16_t words[2], clocks[2]; // [select level]
+        uint16_t changes[2][2]; // [select level][edge]
+        uint16_t text[2][2][2]; // [select level][edge][order]
+        uint16_t polls[2], high[2]; // [select level]
+    } detect;
     SPI_SETTINGS_t settings;
 } SPI;
 
 static void SPI_Decode(void);
+static void SPI_Select(uint8_t data);
 static void SPI_KeyUp(KEYPAD_KEY_t key);
 static void SPI_SettingsLoop(void);
 static void SPI_SettingsKeyUp(KEYPAD_KEY_t key);
+static void SPI_SettingsSelect(void);
+static void SPI_DetectStart(void);
+static void SPI_DetectLoop(void);
+static void SPI_DetectKeyUp(KEYPAD_KEY_t key);
+static void SPI_DetectSample(uint8_t sample);
+static void SPI_DetectFrame(void);
+static void SPI_DetectApply(void);
 static void SPI_Info(void);
 static void SPI_Desc(void);
 static void SPI_Icons(void);
 static inline void SPI_ClockEdge(void);
+static inline void SPI_WordStart(void);
+static void SPI_WordChunk(uint8_t bits);
+static void SPI_WordPartial(void);
 static inline void SPI_SaveSettings(void);
 static inline void SPI_LoadSettings(void);
 
 void SPI_Init(void) {
     SPI_LoadSettings();
+    SPI_WordStart();
     DISPLAY_Mode(DISPLAY_MODE_USART);
     SPI_Info();
     SPI_Desc();
@@ -131,61 +169,49 @@ static inline void SPI_ClockEdge(void) {
 }
 
 static void SPI_Decode(void) {
-    static uint8_t byte, bit;
-    while(!BUFFER_Empty()) {
-        uint8_t data = BUFFER_GetData();
-        if((data&SPI_SS_bm)^SPI.select) {
-            if(bit>0) {
-                if(bit>3) {
-                    DIGITAL_PrintHex(byte>>4);
-                }
-                DIGITAL_PrintChar('?');
-            }
-            if(SPI.settings.select==SPI_SELECT_HIGH) {
-                data^=SPI_SS_bm;
-            }
-            if(data&SPI_SS_bm) {
-                DIGITAL_PrintChar(SPI_STOP);
-                DIGITAL_EndLine();
+    uint16_t size;
+    /* Samples are consumed in contiguous blocks straight from the buffer,
+     * so the cost of locking the buffer is paid per block, not per bit. */
+    while((size = BUFFER_Block())) {
+        const uint8_t* data = &BUFFER.data[BUFFER.first];
+        const uint8_t lsb = (SPI.settings.data==SPI_DATA_LSB);
+        for(uint16_t i=size; i>0; i--) {
+            uint8_t sample = *data++;
+            if((sample&SPI_SS_bm)^SPI.select) {
+                SPI_Select(sample);
             } else {
-                DIGITAL_PrintChar(SPI_START);
-            }
-            if(SPI.input==SPI_MISO_bm) {
-                DIGITAL_InvertLine();
-            }
-            byte = 0x00;
-            bit = 0;
-        } else {
-            if(bit==0) {
-                if(SPI.settings.input) {
-                    SPI.input = SPI_MISO_bm;
-                } else {
-                    SPI.input = SPI_MOSI_bm;
+                if((SPI.left==SPI.settings.width)&&(SPI.chunk==SPI.size)) {
+                    if(SPI.settings.input) {
+                        SPI.input = SPI_MISO_bm;
+                    } else {
+                        SPI.input = SPI_MOSI_bm;
+                    }
                 }
-            }
-            if(SPI.settings.data==SPI_DATA_LSB) {
-                byte>>=1;
-                if(data&SPI.input) {
-                    byte|=0x80;
-                }
-            } else {
-                byte<<=1;
-                if(data&SPI.input) {
-                    byte|=0x01;
+                if(lsb) {
+                    SPI.byte>>=1;
+                    if(sample&SPI.input) {
+                        SPI.byte|=0x80;
+                    }
+                } else {
+                    SPI.byte<<=1;
+                    if(sample&SPI.input) {
+                        SPI.byte|=0x01;
+                    }
                 }
-            }
-            bit++;
-            if(bit>7) {
-                DIGITAL_PrintHex(byte>>4);
-                DIGITAL_PrintHex(byte>>0);
-                byte = 0x00;
-                bit = 0;
-                if(SPI.input==SPI_MISO_bm) {
-                    DIGITAL_InvertLine();
+                if(--SPI.chunk==0) {
+                    SPI_WordChunk(SPI.size);
+                    if(SPI.left==0) {
+                        DIGITAL_PrintWord(SPI.word, (SPI.settings.width+3)/4);
+                        if(SPI.input==SPI_MISO_bm) {
+                            DIGITAL_InvertLine();
+                        }
+                        SPI_WordStart();
+                    }
                 }
             }
+            SPI.select = sample&SPI_SS_bm;
         }
-        SPI.select = data&SPI_SS_bm;
+        BUFFER_Release(size);
     }
     if(DIGITAL_ClockPeriod()<SPI_MIN_CLOCK_PERIOD) {
         DIGITAL_Blackout();
@@ -193,6 +219,72 @@ static void SPI_Decode(void) {
     }
 }
 
+static void SPI_Select(uint8_t data) {
+    SPI_WordPartial();
+    if(SPI.settings.select==SPI_SELECT_HIGH) {
+        data^=SPI_SS_bm;
+    }
+    if(data&SPI_SS_bm) {
+        DIGITAL_PrintChar(SPI_STOP);
+        DIGITAL_EndLine();
+    } else {
+        DIGITAL_PrintChar(SPI_START);
+    }
+    if(SPI.input==SPI_MISO_bm) {
+        DIGITAL_InvertLine();
+    }
+    SPI_WordStart();
+}
+
+/* Word is assembled from byte sized chunks, so the cost per bit stays the
+ * same as for 8-bit words. Odd bits go to the first chunk (MSB first)
+ * or to the last one (LSB first). */
+static inline void SPI_WordStart(void) {
+    uint8_t width = SPI.settings.width;
+    uint8_t size = 8;
+    if(SPI.settings.data==SPI_DATA_MSB) {
+        if(width&0x07) { size = width&0x07; }
+    } else {
+        if(width<8) { size = width; }
+    }
+    SPI.word = 0;
+    SPI.byte = 0x00;
+    SPI.left = width;
+    SPI.size = size;
+    SPI.chunk = size;
+}
+
+static void SPI_WordChunk(uint8_t bits) {
+    if(SPI.settings.data==SPI_DATA_MSB) {
+        if(bits==8) { // constant shift compiles to byte moves
+            SPI.word = (SPI.word<<8)|SPI.byte;
+        } else {
+            SPI.word = (SPI.word<<bits)|SPI.byte;
+        }
+    } else {
+        uint8_t shift = SPI.settings.width-SPI.left;
+        SPI.word |= (uint32_t)(uint8_t)(SPI.byte>>(8-bits))<<shift;
+    }
+    SPI.byte = 0x00;
+    SPI.left -= bits;
+    SPI.size = (SPI.left<8) ? SPI.left : 8;
+    SPI.chunk = SPI.size;
+}
+
+static void SPI_WordPartial(void) {
+    SPI_WordChunk(SPI.size-SPI.chunk);
+    uint8_t bits = SPI.settings.width-SPI.left;
+    if(bits==0) { return; }
+    uint32_t word = SPI.word;
+    if(SPI.settings.data==SPI_DATA_MSB) {
+        word >>= (bits&0x03);
+    }
+    for(uint8_t i=bits/4; i>0; i--) {
+        DIGITAL_PrintHex(word>>((i-1)*4));
+    }
+    DIGITAL_PrintChar('?');
+}
+
 static void SPI_KeyUp(KEYPAD_KEY_t key) {
     if(DIGITAL_Lock()&&(key!=KEYPAD_KEY1)) {
         return;
@@ -202,7 +294,8 @@ static void SPI_KeyUp(KEYPAD_KEY_t key) {
             DIGITAL_Hold(1);
             KEYPAD_KeyUp(SPI_SettingsKeyUp);
             MAIN_Loop(SPI_SettingsLoop);
-            DISPLAY_Select(-1);
+            SPI.line = SPI_LINE_DATA;
+            SPI_SettingsSelect();
             break;
         case KEYPAD_KEY2:
             if(DIGITAL_IsHold()) { break; }
@@ -246,35 +339,77 @@ static inline const __flash char* SPI_SELECT(void) {
 
 static void SPI_SettingsLoop(void) {
     if(!DISPLAY_Update()) { return; }
-    DISPLAY_CursorPosition(7, 1);
-    puts_P(TEXT_SPI_SETTINGS);
-    DISPLAY_CursorPosition(3,15);
+    if(SPI.line==SPI_LINE_AUTO) {
+        DISPLAY_CursorPosition(10, 1);
+        puts_P(TEXT_AUTO_DETECT);
+    } else {
+        DISPLAY_CursorPosition(7, 1);
+        puts_P(TEXT_SPI_SETTINGS);
+    }
+    DISPLAY_CursorPosition(3,12);
     printf_P(TEXT_DATA, SPI_DATA());
-    DISPLAY_CursorPosition(3,24);
+    DISPLAY_CursorPosition(3,21);
     printf_P(TEXT_CLOCK, SPI_CLOCK());
-    DISPLAY_CursorPosition(3,33);
+    DISPLAY_CursorPosition(3,30);
     printf_P(TEXT_SELECT, SPI_SELECT());
+    DISPLAY_CursorPosition(3,39);
+    printf_P(TEXT_WORD, SPI.settings.width);
     DISPLAY_InvertLine(0);
     DISPLAY_SelectLine();
 }
 
+static void SPI_SettingsChange(int8_t step) {
+    switch(SPI.line) {
+        case SPI_LINE_DATA:
+            SPI.settings.data = !SPI.settings.data;
+            break;
+        case SPI_LINE_CLOCK:
+            SPI.settings.clock = !SPI.settings.clock;
+            break;
+        case SPI_LINE_SELECT:
+            SPI.settings.select = !SPI.settings.select;
+            break;
+        case SPI_LINE_WIDTH:
+            SPI.settings.width += step;
+            if(SPI.settings.width<SPI_WIDTH_MIN) {
+                SPI.settings.width = SPI_WIDTH_MAX;
+            }
+            if(SPI.settings.width>SPI_WIDTH_MAX) {
+                SPI.settings.width = SPI_WIDTH_MIN;
+            }
+            break;
+        case SPI_LINE_AUTO:
+            SPI_DetectStart();
+            break;
+    }
+}
+
+static void SPI_SettingsSelect(void) {
+    if(SPI.line==SPI_LINE_AUTO) {
+        DISPLAY_Select(0);
+    } else {
+        DISPLAY_Select(11+(SPI.line*9));
+    }
+}
+
 static void SPI_SettingsKeyUp(KEYPAD_KEY_t key) {
     switch(key) {
         case KEYPAD_KEY1:
-            SPI.settings.data = !SPI.settings.data;
-            DISPLAY_Select(14);
+            if((SPI.line++)==SPI_LINE_AUTO) {
+                SPI.line = SPI_LINE_DATA;
+            }
+            SPI_SettingsSelect();
             break;
         case KEYPAD_KEY2:
-            SPI.settings.clock = !SPI.settings.clock;
-            DISPLAY_Select(23);
+            SPI_SettingsChange(-1);
             break;
         case KEYPAD_KEY3:
-            SPI.settings.select = !SPI.settings.select;
-            DISPLAY_Select(32);
+            SPI_SettingsChange(1);
             break;
         case KEYPAD_KEY4:
             SPI_SaveSettings();
             SPI_ClockEdge();
+            SPI_WordStart();
             KEYPAD_KeyUp(SPI_KeyUp);
             DIGITAL_Init(SPI_Decode);
             DIGITAL_Hold(0);
@@ -283,6 +418,140 @@ static void SPI_SettingsKeyUp(KEYPAD_KEY_t key) {
     }
 }
 
+/* Auto detection captures both SCK edges together with CS edges. Every
+ * CS frame is split into leading and trailing edges and scored separately
+ * for each CS level: data changes on the shift edge and stays stable on
+ * the sampling edge, frame length should be a multiple of the word width
+ * and the bit order that decodes more printable text wins (MSB first
+ * otherwise). SCK idle level is polled while CS is inactive. */
+static void SPI_DetectStart(void) {
+    uint8_t* detect = (uint8_t*)&SPI.detect;
+    for(uint8_t i=0; i<sizeof(SPI.detect); i++) {
+        detect[i] = 0;
+    }
+    SPI.detect.prev = PORTC_IN;
+    KEYPAD_KeyUp(SPI_DetectKeyUp);
+    MAIN_Loop(SPI_DetectLoop);
+    DISPLAY_Select(-1);
+    PORTA_PIN1CTRL = PORT_OPC_BUSKEEPER_gc|PORT_ISC_BOTHEDGES_gc; // SCK
+    BUFFER_Start();
+    BUFFER_Clear();
+}
+
+static void SPI_DetectLoop(void) {
+    uint8_t level = (PORTC_IN&SPI_SS_bm) ? 1 : 0;
+    if(SPI.detect.polls[level]&0x8000) {
+        SPI.detect.polls[level] >>= 1;
+        SPI.detect.high[level] >>= 1;
+    }
+    SPI.detect.polls[level]++;
+    if(PORTA_IN&SPI_SCK_bm) {
+        SPI.detect.high[level]++;
+    }
+    if(BUFFER_Overflow()) {
+        BUFFER_Clear();
+        SPI.detect.valid = 0;
+    }
+    uint16_t size;
+    while((size = BUFFER_Block())) {
+        const uint8_t* data = &BUFFER.data[BUFFER.first];
+        for(uint16_t i=size; i>0; i--) {
+            SPI_DetectSample(*data++);
+        }
+        BUFFER_Release(size);
+    }
+    if((SPI.detect.count>=SPI_DETECT_FRAMES)||(SPI.detect.total>=SPI_DETECT_EDGES)) {
+        SPI_DetectApply();
+        return;
+    }
+    if(!DISPLAY_Update()) { return; }
+    DISPLAY_CursorPosition(10, 1);
+    puts_P(TEXT_AUTO_DETECT);
+    DISPLAY_CursorPosition(3,21);
+    printf_P(TEXT_FRAMES, SPI.detect.count);
+    DISPLAY_InvertLine(0);
+}
+
+static void SPI_DetectKeyUp(KEYPAD_KEY_t key) {
+    (void)key; //unused
+    SPI_DetectApply();
+}
+
+static void SPI_DetectSample(uint8_t sample) {
+    uint8_t diff = sample^SPI.detect.prev;
+    SPI.detect.prev = sample;
+    if(diff&SPI_SS_bm) {
+        if(SPI.detect.valid) {
+            SPI_DetectFrame();
+        }
+        SPI.detect.valid = 1;
+        SPI.detect.edges = 0;
+        return;
+    }
+    if(!SPI.detect.valid) { return; }
+    uint8_t level = (sample&SPI_SS_bm) ? 1 : 0;
+    uint8_t edge = SPI.detect.edges&0x01;
+    uint8_t* byte = SPI.detect.byte[edge];
+    if(diff&SPI_MOSI_bm) { SPI.detect.changes[level][edge]++; }
+    if(diff&SPI_MISO_bm) { SPI.detect.changes[level][edge]++; }
+    byte[SPI_DATA_MSB] <<= 1;
+    byte[SPI_DATA_LSB] >>= 1;
+    if(sample&SPI.input) {
+        byte[SPI_DATA_MSB] |= 0x01;
+        byte[SPI_DATA_LSB] |= 0x80;
+    }
+    if(((SPI.detect.edges>>1)&0x07)==0x07) {
+        for(uint8_t order=0; order<2; order++) {
+            if((byte[order]>=' ')&&(byte[order]<0x7F)) {
+                SPI.detect.text[level][edge][order]++;
+            }
+        }
+    }
+    SPI.detect.edges++;
+    SPI.detect.total++;
+}
+
+static void SPI_DetectFrame(void) {
+    uint16_t edges = SPI.detect.edges;
+    if(edges==0) { return; }
+    uint8_t level = (SPI.detect.prev&SPI_SS_bm) ? 0 : 1; // level before CS edge
+    SPI.detect.clocks[level] += edges>>1;
+    if(!(edges&0x01)&&(((edges>>1)%SPI.settings.width)==0)) {
+        SPI.detect.words[level]++;
+    }
+    SPI.detect.count++;
+}
+
+static void SPI_DetectApply(void) {
+    BUFFER_Stop();
+    if(SPI.detect.count) {
+        uint8_t active = 0;
+        if(SPI.detect.words[1]!=SPI.detect.words[0]) {
+            active = (SPI.detect.words[1]>SPI.detect.words[0]);
+        } else {
+            active = (SPI.detect.clocks[1]>SPI.detect.clocks[0]);
+        }
+        uint8_t idle = !active;
+        uint8_t polarity = (SPI.detect.high[idle]>(SPI.detect.polls[idle]>>1));
+        uint16_t* changes = SPI.detect.changes[active];
+        uint8_t edge = (changes[1]<changes[0]); // 0 - leading, 1 - trailing
+        uint16_t* text = SPI.detect.text[active][edge];
+        SPI.settings.select = active ? SPI_SELECT_HIGH : SPI_SELECT_LOW;
+        SPI.settings.clock = (edge==polarity) ? SPI_CLOCK_RISING : SPI_CLOCK_FALLING;
+        if((text[SPI_DATA_LSB]>=4)&&(text[SPI_DATA_LSB]>(text[SPI_DATA_MSB]*2))) {
+            SPI.settings.data = SPI_DATA_LSB;
+        } else {
+            SPI.settings.data = SPI_DATA_MSB;
+        }
+        SPI_SaveSettings();
+    }
+    SPI_ClockEdge();
+    KEYPAD_KeyUp(SPI_SettingsKeyUp);
+    MAIN_Loop(SPI_SettingsLoop);
+    SPI.line = SPI_LINE_DATA;
+    SPI_SettingsSelect();
+}
+
 void SPI_Intro(void) {
     DISPLAY_Image(IMAGE_SPI);
     SPI_Icons();
@@ -353,5 +622,9 @@ static inline void SPI_LoadSettings(void) {
     if(SPI.settings.input>SPI_INPUT_MISO) {
         SPI.settings.input = SPI_INPUT_MOSI;
     }
+    uint8_t width = SPI.settings.width;
+    if((width<SPI_WIDTH_MIN)||(width>SPI_WIDTH_MAX)) {
+        SPI.settings.width = SPI_WIDTH_DEF;
+    }
     SPI_SaveSettings();
 }
@@ -26,6 +26,7 @@ const __flash char TEXT_SLOWER[] = "SLOWER";
 const __flash char TEXT_FASTER[] = "FASTER";
 const __flash char TEXT_TIMER[] = "TIMER";
 const __flash char TEXT_SCALE[] = "SCALE";
+const __flash char TEXT_STATS[] = "STATS";
 const __flash char TEXT_START_STOP[] = "START/STOP";
 const __flash char TEXT_ACK_NACK[] = "ACK/NACK";
 const __flash char TEXT_HOLD_RUN[] = "HOLD/RUN";
@@ -67,20 +68,53 @@ const __flash char TEXT_SPI_SETTINGS[] = "SPI SETTINGS";
 const __flash char TEXT_DATA[] = "DATA: %S";
 const __flash char TEXT_CLOCK[] = "CLOCK: %S";
 const __flash char TEXT_SELECT[] = "SELECT: %S";
+const __flash char TEXT_WORD[] = "WORD: %u BIT";
+const __flash char TEXT_AUTO_DETECT[] = "AUTO DETECT";
+const __flash char TEXT_FRAMES[] = "FRAMES: %u";
 /* USART */
 const __flash char TEXT_UART_SETTINGS[] = "UART SETTINGS";
 const __flash char TEXT_USRT_SETTINGS[] = "USRT SETTINGS";
 const __flash char TEXT_BAUD[] = "BAUD: %lu";
+const __flash char TEXT_BAUD_AUTO[] = "BAUD: AUTO";
+const __flash char TEXT_BAUD_RATE[] = "=%lu %c%u.%u%%";
+const __flash char TEXT_CUSTOM_BAUD[] = "CUSTOM BAUD";
+const __flash char TEXT_STEP[] = "STEP: %lu";
+const __flash char TEXT_AUTO_BAUD[] = "AUTO BAUD";
+const __flash char TEXT_BAUD_ERROR[] = "ERROR: %c%u.%u%%";
+const __flash char TEXT_RX_BITS[] = "RX%u BITS: %u";
 const __flash char TEXT_FRAME[] = "FRAME: %u BIT";
 const __flash char TEXT_PARITY[] = "PARITY: %S";
+const __flash char TEXT_FRAME_FORMAT[] = "FRAME: %u%c1";
+const __flash char TEXT_GAP[] = "GAP: %u.%u CHAR";
+const __flash char TEXT_GAP_OFF[] = "GAP: OFF";
+const __flash char TEXT_GAPS[] = "GAPS";
+const __flash char TEXT_GAP_TIME[] = "%c%3u.%03u MS";
+const __flash char TEXT_GAP_OVER[] = "%c>131 MS";
+const __flash char TEXT_MODBUS_RTU[] = "MODBUS RTU";
+const __flash char TEXT_LIN_BUS[] = "LIN BUS";
 /* IRCOM */
 const __flash char TEXT_IRCOM_SETTINGS[] = "IRCOM SETTINGS";
 const __flash char TEXT_INVERT[] = "INVERT:";
+const __flash char TEXT_IR_REMOTE[] = "IR REMOTE";
+const __flash char TEXT_IR_PROTOCOLS[] = "NEC RC5/6 SIRC";
+const __flash char TEXT_IR_NEC[] = "NEC ";
+const __flash char TEXT_IR_SIRC[] = "SIRC ";
+const __flash char TEXT_IR_RC5[] = "RC5 ";
+const __flash char TEXT_IR_RC6[] = "RC6 ";
 /* 1-WIRE */
 const __flash char TEXT_1WIRE_INFO[] = "1-WIRE INFO";
 const __flash char TEXT_RESET[] = "RESET (R)";
 const __flash char TEXT_RESPONSE[] = "RESPONSE:";
 const __flash char TEXT_YES_NO[] = "YES(+) NO(-)";
+const __flash char TEXT_SLOT[] = "%S %u";
+const __flash char TEXT_SLOT_OD[] = "OD ";
+const __flash char TEXT_SLOT_RESET[] = "RESET";
+const __flash char TEXT_SLOT_PRESENCE[] = "PRES.";
+const __flash char TEXT_SLOT_ZERO[] = "BIT 0";
+const __flash char TEXT_SLOT_ONE[] = "BIT 1";
+const __flash char TEXT_SLOT_MIN[] = "MIN %3u.%u US";
+const __flash char TEXT_SLOT_AVG[] = "AVG %3u.%u US";
+const __flash char TEXT_SLOT_MAX[] = "MAX %3u.%u US";
 /* DELAY */
 const __flash char TEXT_DELAY_SETUP[] = "DELAY SETUP";
 const __flash char TEXT_DELAY_INFO[] = "INFO: %ds";
@@ -98,10 +132,49 @@ const __flash char TEXT_REFRESH[] = "REFRESH: %2d";
 const __flash char TEXT_BACKLIGHT[] = "BACKLIGHT:";
 /* ANALOG */
 const __flash char TEXT_ADC_SCALE[] = "%3u";
+const __flash char TEXT_ADC_SCALE_K[] = "%2uk";
 const __flash char TEXT_ADC_CALIBRATION[] = "ADC CALIB.";
 const __flash char TEXT_ADC_VALUE[] = "VALUE:";
 const __flash char TEXT_ADC_OFFSET[] = "OFFSET:%6d";
 const __flash char TEXT_ADC_GAIN[] = "GAIN:%2d.%03d";
+const __flash char TEXT_ADC_RANGE[] = "RANGE: x%u";
+const __flash char TEXT_ADC_RANGE_MARK[] = "%u";
+const __flash char TEXT_ADC_POINT[] = "POINT%u:";
+const __flash char TEXT_ADC_RAW[] = "RAW:%6d";
+const __flash char TEXT_ADC_RAW_NONE[] = "RAW:  ----";
+const __flash char TEXT_ADC_STEP[] = "STEP:%5u";
+const __flash char TEXT_ADC_CREST[] = " %2u.%02u";
+const __flash char TEXT_ADC_COUNT[] = "%3u";
+const __flash char TEXT_ADC_TIME[] = "%lu.%03us";
+const __flash char TEXT_SCOPE_SETTINGS[] = "SCOPE SETTINGS";
+const __flash char TEXT_SCOPE_EDGE[] = "EDGE:";
+const __flash char TEXT_SCOPE_BOTH[] = "BOTH";
+const __flash char TEXT_SCOPE_PRE[] = "PRE-TRIG: %u%%";
+const __flash char TEXT_SCOPE_BASE[] = "BASE: %u/COL";
+const __flash char TEXT_SCOPE_AUTO[] = "AUT";
+const __flash char TEXT_SCOPE_NORMAL[] = "NRM";
+const __flash char TEXT_SCOPE_SINGLE[] = "SGL";
+const __flash char TEXT_FFT_FREQUENCY[] = "%5luHz";
+const __flash char TEXT_ADC_SETTINGS[] = "ADC SETTINGS";
+const __flash char TEXT_ADC_PRESCALER[] = "CLOCK: /%u";
+const __flash char TEXT_ADC_SAMPNUM[] = "AVERAGE: %uX";
+const __flash char TEXT_ADC_SAMPLING[] = "SAMPLE: %uCLK";
+const __flash char TEXT_ADC_BANDWIDTH[] = "%u.%ub %5luHz";
+const __flash char TEXT_ADC_FILTER[] = "ADC FILTER";
+const __flash char TEXT_FILTER_MODE[] = "TYPE: %S";
+const __flash char TEXT_FILTER_BOXCAR[] = "BOXCAR";
+const __flash char TEXT_FILTER_IIR[] = "IIR";
+const __flash char TEXT_FILTER_NOTCH50[] = "NOTCH50";
+const __flash char TEXT_FILTER_NOTCH60[] = "NOTCH60";
+const __flash char TEXT_FILTER_LENGTH[] = "LENGTH: %u";
+const __flash char TEXT_FILTER_CUTOFF[] = "-3dB: %5luHz";
+const __flash char TEXT_FILTER_WIDTH[] = "WIDTH: %uHz";
+const __flash char TEXT_FILTER_RATE[] = "OFF (RATE)";
+const __flash char TEXT_STAT_MEAN[] = "AVG";
+const __flash char TEXT_STAT_RMS[] = "RMS";
+const __flash char TEXT_STAT_STD[] = "STD";
+const __flash char TEXT_STAT_PP[] = "P-P";
+const __flash char TEXT_STAT_CREST[] = "CRF";
 /* FREQ */
 const __flash char TEXT_FREQ_nnn[] = "%5u";
 const __flash char TEXT_FREQ_dnn[] = "%2u.%02u";
@@ -109,12 +182,20 @@ const __flash char TEXT_FREQ_ddn[] = "%3u.%u";
 const __flash char TEXT_FREQ_Hz[] = "Hz";
 const __flash char TEXT_FREQ_kHz[] = "kHz";
 const __flash char TEXT_FREQ_MHz[] = "MHz";
+/* POWER */
+const __flash char TEXT_POWER_UNIT[] = "W";
+const __flash char TEXT_POWER_VALUE[] = "%c%u.%03u";
+const __flash char TEXT_POWER_SKEW[] = "%5lu";
+const __flash char TEXT_POWER_US[] = "us";
+const __flash char TEXT_POWER_SKW[] = "SKW";
 /* CHARGE */
 const __flash char TEXT_CHARGE_muu[] = "%c%u.%02u";
 const __flash char TEXT_CHARGE_mmu[] = "%c%2u.%u";
 const __flash char TEXT_CHARGE_mmm[] = "%c%4u";
 const __flash char TEXT_CHARGE_UNIT[] = "mAh";
 const __flash char TEXT_CHARGE_TIME[] = "%02u:%02u:%02u";
+const __flash char TEXT_ENERGY_mWh[] = "mWh";
+const __flash char TEXT_ENERGY_Wh[] = "Wh";
 /* INFO */
 const __flash char TEXT_INFO_FIRMWARE[] = "FIRMWARE:";
 const __flash char TEXT_INFO_VERSION[] = "F1 v1.1";
@@ -129,5 +210,6 @@ const __flash char TEXT_DESC_STOP[] = "> STOP";
 const __flash char TEXT_PARITY_ERR[] = "\x80 PARITY ERR.";
 const __flash char TEXT_FRAME_ERR[] = "\x81 FRAME ERR.";
 const __flash char TEXT_OVERFLOW[] = "\x82 OVERFLOW";
+const __flash char TEXT_BREAK[] = "\x85 BREAK";
 const __flash char TEXT_DATA_ERR[] = "\x83 DATA ERR.";
 const __flash char TEXT_FREQ_ERR[] = "\x84 FREQ. ERR.";
@@ -24,6 +24,7 @@ extern const __flash char TEXT_SLOWER[];
 extern const __flash char TEXT_FASTER[];
 extern const __flash char TEXT_TIMER[];
 extern const __flash char TEXT_SCALE[];
+extern const __flash char TEXT_STATS[];
 extern const __flash char TEXT_START_STOP[];
 extern const __flash char TEXT_ACK_NACK[];
 extern const __flash char TEXT_HOLD_RUN[];
@@ -63,17 +64,50 @@ extern const __flash char TEXT_SPI_SETTINGS[];
 extern const __flash char TEXT_DATA[];
 extern const __flash char TEXT_CLOCK[];
 extern const __flash char TEXT_SELECT[];
+extern const __flash char TEXT_WORD[];
+extern const __flash char TEXT_AUTO_DETECT[];
+extern const __flash char TEXT_FRAMES[];
 extern const __flash char TEXT_UART_SETTINGS[];
 extern const __flash char TEXT_USRT_SETTINGS[];
 extern const __flash char TEXT_BAUD[];
+extern const __flash char TEXT_BAUD_AUTO[];
+extern const __flash char TEXT_BAUD_RATE[];
+extern const __flash char TEXT_CUSTOM_BAUD[];
+extern const __flash char TEXT_STEP[];
+extern const __flash char TEXT_AUTO_BAUD[];
+extern const __flash char TEXT_BAUD_ERROR[];
+extern const __flash char TEXT_RX_BITS[];
 extern const __flash char TEXT_FRAME[];
 extern const __flash char TEXT_PARITY[];
+extern const __flash char TEXT_FRAME_FORMAT[];
+extern const __flash char TEXT_GAP[];
+extern const __flash char TEXT_GAP_OFF[];
+extern const __flash char TEXT_GAPS[];
+extern const __flash char TEXT_GAP_TIME[];
+extern const __flash char TEXT_GAP_OVER[];
+extern const __flash char TEXT_MODBUS_RTU[];
+extern const __flash char TEXT_LIN_BUS[];
 extern const __flash char TEXT_IRCOM_SETTINGS[];
 extern const __flash char TEXT_INVERT[];
+extern const __flash char TEXT_IR_REMOTE[];
+extern const __flash char TEXT_IR_PROTOCOLS[];
+extern const __flash char TEXT_IR_NEC[];
+extern const __flash char TEXT_IR_SIRC[];
+extern const __flash char TEXT_IR_RC5[];
+extern const __flash char TEXT_IR_RC6[];
 extern const __flash char TEXT_1WIRE_INFO[];
 extern const __flash char TEXT_RESET[];
 extern const __flash char TEXT_RESPONSE[];
 extern const __flash char TEXT_YES_NO[];
+extern const __flash char TEXT_SLOT[];
+extern const __flash char TEXT_SLOT_OD[];
+extern const __flash char TEXT_SLOT_RESET[];
+extern const __flash char TEXT_SLOT_PRESENCE[];
+extern const __flash char TEXT_SLOT_ZERO[];
+extern const __flash char TEXT_SLOT_ONE[];
+extern const __flash char TEXT_SLOT_MIN[];
+extern const __flash char TEXT_SLOT_AVG[];
+extern const __flash char TEXT_SLOT_MAX[];
 extern const __flash char TEXT_DELAY_SETUP[];
 extern const __flash char TEXT_DELAY_INFO[];
 extern const __flash char TEXT_DELAY_IDLE[];
@@ -86,21 +120,67 @@ extern const __flash char TEXT_CONTRAST[];
 extern const __flash char TEXT_REFRESH[];
 extern const __flash char TEXT_BACKLIGHT[];
 extern const __flash char TEXT_ADC_SCALE[];
+extern const __flash char TEXT_ADC_SCALE_K[];
 extern const __flash char TEXT_ADC_CALIBRATION[];
 extern const __flash char TEXT_ADC_VALUE[];
 extern const __flash char TEXT_ADC_OFFSET[];
 extern const __flash char TEXT_ADC_GAIN[];
+extern const __flash char TEXT_ADC_RANGE[];
+extern const __flash char TEXT_ADC_RANGE_MARK[];
+extern const __flash char TEXT_ADC_POINT[];
+extern const __flash char TEXT_ADC_RAW[];
+extern const __flash char TEXT_ADC_RAW_NONE[];
+extern const __flash char TEXT_ADC_STEP[];
+extern const __flash char TEXT_ADC_CREST[];
+extern const __flash char TEXT_ADC_COUNT[];
+extern const __flash char TEXT_ADC_TIME[];
+extern const __flash char TEXT_SCOPE_SETTINGS[];
+extern const __flash char TEXT_SCOPE_EDGE[];
+extern const __flash char TEXT_SCOPE_BOTH[];
+extern const __flash char TEXT_SCOPE_PRE[];
+extern const __flash char TEXT_SCOPE_BASE[];
+extern const __flash char TEXT_SCOPE_AUTO[];
+extern const __flash char TEXT_SCOPE_NORMAL[];
+extern const __flash char TEXT_SCOPE_SINGLE[];
+extern const __flash char TEXT_FFT_FREQUENCY[];
+extern const __flash char TEXT_ADC_SETTINGS[];
+extern const __flash char TEXT_ADC_PRESCALER[];
+extern const __flash char TEXT_ADC_SAMPNUM[];
+extern const __flash char TEXT_ADC_SAMPLING[];
+extern const __flash char TEXT_ADC_BANDWIDTH[];
+extern const __flash char TEXT_ADC_FILTER[];
+extern const __flash char TEXT_FILTER_MODE[];
+extern const __flash char TEXT_FILTER_BOXCAR[];
+extern const __flash char TEXT_FILTER_IIR[];
+extern const __flash char TEXT_FILTER_NOTCH50[];
+extern const __flash char TEXT_FILTER_NOTCH60[];
+extern const __flash char TEXT_FILTER_LENGTH[];
+extern const __flash char TEXT_FILTER_CUTOFF[];
+extern const __flash char TEXT_FILTER_WIDTH[];
+extern const __flash char TEXT_FILTER_RATE[];
+extern const __flash char TEXT_STAT_MEAN[];
+extern const __flash char TEXT_STAT_RMS[];
+extern const __flash char TEXT_STAT_STD[];
+extern const __flash char TEXT_STAT_PP[];
+extern const __flash char TEXT_STAT_CREST[];
 extern const __flash char TEXT_FREQ_nnn[];
 extern const __flash char TEXT_FREQ_dnn[];
 extern const __flash char TEXT_FREQ_ddn[];
 extern const __flash char TEXT_FREQ_Hz[];
 extern const __flash char TEXT_FREQ_kHz[];
 extern const __flash char TEXT_FREQ_MHz[];
+extern const __flash char TEXT_POWER_UNIT[];
+extern const __flash char TEXT_POWER_VALUE[];
+extern const __flash char TEXT_POWER_SKEW[];
+extern const __flash char TEXT_POWER_US[];
+extern const __flash char TEXT_POWER_SKW[];
 extern const __flash char TEXT_CHARGE_muu[];
 extern const __flash char TEXT_CHARGE_mmu[];
 extern const __flash char TEXT_CHARGE_mmm[];
 extern const __flash char TEXT_CHARGE_UNIT[];
 extern const __flash char TEXT_CHARGE_TIME[];
+extern const __flash char TEXT_ENERGY_mWh[];
+extern const __flash char TEXT_ENERGY_Wh[];
 extern const __flash char TEXT_INFO_FIRMWARE[];
 extern const __flash char TEXT_INFO_VERSION[];
 extern const __flash char TEXT_INFO_RAM[];
@@ -113,6 +193,7 @@ extern const __flash char TEXT_DESC_STOP[];
 extern const __flash char TEXT_PARITY_ERR[];
 extern const __flash char TEXT_FRAME_ERR[];
 extern const __flash char TEXT_OVERFLOW[];
+extern const __flash char TEXT_BREAK[];
 extern const __flash char TEXT_DATA_ERR[];
 extern const __flash char TEXT_FREQ_ERR[];
 
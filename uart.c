@@ -15,6 +15,7 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ***************************************************************************/
 #include <avr/io.h>
 #include <avr/eeprom.h>
+#include "avr/iox32e5.h"
 #include "avr/eeprom.h"
 #include "main.h"
 #include "text.h"
@@ -29,16 +30,72 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "image.h"
 #include "uart.h"
 
+#define UART_AUTO_MARK     16 // counter value read just after TCC5 overflow
+#define UART_AUTO_JITTER    2 // variation of the counter value read after overflow
+#define UART_AUTO_GLITCH   12 // <375ns
+#define UART_AUTO_WINDOW   64 // pulses used to find the bit period
+#define UART_AUTO_BITS   1024 // bits used to refine the bit period and frame
+#define UART_AUTO_RUN      12 // longer run means idle line (or break)
+#define UART_AUTO_SWITCH   32 // display updates before switching RX line
+#define UART_AUTO_ERROR    30 // 3.0% (max. error for standard baud rate)
+#define UART_AUTO_FRAMES    8 // frames checked before a frame length is accepted
+#define UART_AUTO_COMMON    3 // 10-bit frame (8N1, 7E1, 7O1)
+#define UART_GAPS           4 // gaps shown in hold mode
+#define UART_MODBUS_GAP     7 // 3.5 character times of idle line (half character units)
+#define UART_MODBUS_FIXED 875 // 1.75ms above 19200 baud (2us units)
+#define UART_LIN_GAP       16 // 8 character times
+#define UART_LIN_SYNC    0x55
+
+typedef enum {
+    UART_PROTOCOL_RAW,
+    UART_PROTOCOL_MODBUS,
+    UART_PROTOCOL_LIN
+} UART_PROTOCOL_t;
+
+typedef enum {
+    UART_FRAME_IDLE,
+    UART_FRAME_SYNC,
+    UART_FRAME_HEADER,
+    UART_FRAME_DATA
+} UART_FRAME_t;
+
+typedef struct {
+    uint8_t pos, sum;
+    uint16_t frames, errors, even;
+} UART_CHECK_t;
+
 typedef struct {
     USART_BAUD_t baud;
     USART_FRAME_t frame;
     USART_PARITY_t parity;
     DIGITAL_DISPLAY_t display;
+    uint32_t custom;
+    uint8_t gap;
+    UART_PROTOCOL_t protocol;
 } UART_SETTINGS_t;
 
 static UART_SETTINGS_t UART_settings EEMEM;
 static struct {
-    uint8_t dir;
+    uint8_t dir, view, last, pause;
+    uint16_t ctrl, gap;
+    uint16_t character; // one character time (2us units)
+    uint32_t baud;
+    struct {
+        uint8_t dir;
+        uint16_t time;
+    } gaps[UART_GAPS];
+    struct {
+        UART_FRAME_t state;
+        uint8_t length, error, pid, sum;
+        uint16_t crc;
+    } frame;
+    struct {
+        uint8_t input, phase, sync, idle, level, ticks;
+        uint8_t wrapped, mark; // overflow of this TCC5 period seen, its value
+        uint16_t high, count;
+        uint32_t last, min, sum;
+        UART_CHECK_t check[5]; // frame length 7..11 bits
+    } detect;
     UART_SETTINGS_t settings;
 } UART;
 
@@ -47,6 +104,24 @@ static void UART_KeyUp(KEYPAD_KEY_t key);
 static void UART_Setup(USART_t* const usart);
 static void UART_SettingsLoop(void);
 static void UART_SettingsKeyUp(KEYPAD_KEY_t key);
+static void UART_SettingsExit(void);
+static void UART_BaudCtrl(void);
+static void UART_GapLog(uint8_t dir, uint16_t time);
+static void UART_GapLoop(void);
+static void UART_Frame(uint8_t status, uint8_t data);
+static void UART_FrameModbus(uint8_t status, uint8_t data);
+static void UART_FrameLin(uint8_t status, uint8_t data);
+static void UART_FrameEnd(void);
+static void UART_AutoStart(void);
+static void UART_AutoInput(void);
+static void UART_AutoLoop(void);
+static void UART_AutoKeyUp(KEYPAD_KEY_t key);
+static void UART_AutoSample(uint16_t sample);
+static void UART_AutoPulse(uint32_t pulse);
+static void UART_AutoBits(uint8_t level, uint8_t bits);
+static void UART_AutoApply(void);
+static void UART_AutoResult(int16_t error);
+static void UART_AutoStop(void);
 static inline void UART_SaveSettings(void);
 static inline void UART_LoadSettings(void);
 
@@ -73,10 +148,54 @@ void UART_Init(void) {
     ACA.AC1CTRL = AC_HYSMODE_SMALL_gc|AC_ENABLE_bm;
     PORTCFG_ACEVOUT = PORTCFG_ACOUT_PD_gc;
     UART.dir = 0;
+    UART.view = 0;
+    UART.frame.state = UART_FRAME_IDLE;
+    UART.frame.error = 0;
+    if(UART.settings.baud==USART_BAUD_AUTO) {
+        UART_AutoStart();
+    }
+}
+
+static inline uint32_t UART_Baud(void) {
+    if(UART.settings.baud==USART_BAUD_AUTO) {
+        return UART.baud;
+    }
+    if(UART.settings.baud==USART_BAUD_CUSTOM) {
+        return UART.settings.custom;
+    }
+    return USART_Baud(UART.settings.baud);
+}
+
+/* Gap threshold (settings are in half character times), gaps are idle line
+ * measured from the end of the stop bit of the previous character */
+static const __flash uint8_t UART_GAP[] = {0, 3, 4, 5, 6, 7, 8, 10, 12, 16, 20, 40};
+
+static void UART_BaudCtrl(void) {
+    uint32_t baud = UART_Baud();
+    UART.ctrl = USART_BaudAsync(baud);
+    UART.gap = 0;
+    uint8_t bits = 2+USART_Frame(UART.settings.frame);
+    if(UART.settings.parity) { bits++; }
+    UART.character = ((uint32_t)bits*(F_CPU/64))/baud;
+    uint8_t gap = UART_GAP[UART.settings.gap];
+    if(UART.settings.protocol==UART_PROTOCOL_MODBUS) {
+        gap = UART_MODBUS_GAP;
+    } else if(UART.settings.protocol==UART_PROTOCOL_LIN) {
+        gap = UART_LIN_GAP;
+    }
+    if(gap) {
+        uint32_t ticks = (((uint32_t)bits*gap)*(F_CPU/128))/baud;
+        if(ticks>=UINT16_MAX) { ticks = UINT16_MAX-1; }
+        if(ticks==0) { ticks = 1; }
+        UART.gap = ticks;
+    }
+    if((UART.settings.protocol==UART_PROTOCOL_MODBUS)&&(baud>19200)) {
+        UART.gap = UART_MODBUS_FIXED;
+    }
 }
 
 static void UART_Setup(USART_t* const usart) {
-    USART_SetBaudAsync(usart, USART_Baud(UART.settings.baud));
+    USART_SetBaudCtrl(usart, UART.ctrl);
     (usart)->STATUS = 0xFF;
     USART_PMODE_t PMODE_gc = USART_PMODE(UART.settings.parity);
     USART_CHSIZE_t CHSIZE_gc = USART_CHSIZE(UART.settings.frame);
@@ -90,25 +209,208 @@ static void UART_Decode(void) {
         uint8_t status = BUFFER_GetData();
         uint8_t dir = status&(USART_TXCIF_bm|USART_RXCIF_bm);
         if(dir) {
-            if(UART.dir!=dir) {
+            uint16_t time = BUFFER_GetData();
+            time |= (uint16_t)BUFFER_GetData()<<8;
+            /* Time between receptions includes the character itself */
+            uint16_t idle = time;
+            if(time!=UINT16_MAX) {
+                idle = (time>UART.character) ? (time-UART.character) : 0;
+            }
+            if((UART.dir!=dir)||(UART.gap&&(idle>=UART.gap))) {
                 UART.dir = dir;
+                UART.pause = 0;
+                UART_GapLog(dir, idle);
+                UART_FrameEnd();
                 DIGITAL_EndLine();
             }
             uint8_t data = BUFFER_GetData();
-            if(status&(USART_FERR_bm|USART_PERR_bm)) {
+            if(UART.settings.frame!=USART_FRAME_9BIT) {
+                status &= ~USART_RXB8_bm;
+            }
+            if(UART.settings.protocol) {
+                UART_Frame(status, data);
+            } else if((status&USART_FERR_bm)&&!(data|(status&USART_RXB8_bm))) {
+                /* Break is received as zeros with frame error, while the line
+                 * stays low it is repeated (shown only once) */
+                if(!UART.pause) {
+                    UART.pause = 1;
+                    DIGITAL_PrintSymbol(FONT_SYMBOL_BREAK);
+                    DIGITAL_EndLine();
+                }
+            } else if(status&(USART_FERR_bm|USART_PERR_bm)) {
                 data = FONT_SYMBOL_PERR;
                 if(status&USART_FERR_bm) {
                     data = FONT_SYMBOL_FERR;
                 }
                 DIGITAL_PrintSymbol(data);
+            } else if(status&USART_RXB8_bm) {
+                /* Multidrop bus, address (9th bit set) starts new line */
+                DIGITAL_EndLine();
+                DIGITAL_PrintWord(data, 2);
+                DIGITAL_PrintChar(':');
             } else {
                 DIGITAL_Print(data);
             }
+            if(!(status&USART_FERR_bm)) {
+                UART.pause = 0;
+            }
             if(UART.dir==USART_TXCIF_bm) {
                 DIGITAL_InvertLine();
             }
         }
     }
+    /* Last frame is closed when the line stays idle */
+    if(UART.frame.state&&!DIGITAL_IsHold()&&(BUFFER_Idle()>=UART.gap)) {
+        UART_FrameEnd();
+    }
+}
+
+/* CRC-16 (polynomial 0xA001, reflected) */
+static const __flash uint16_t UART_CRC16[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+static void UART_Frame(uint8_t status, uint8_t data) {
+    if(UART.settings.protocol==UART_PROTOCOL_LIN) {
+        UART_FrameLin(status, data);
+    } else {
+        UART_FrameModbus(status, data);
+    }
+}
+
+/* Slave ID and function code are followed by data and CRC (checked on the fly) */
+static void UART_FrameModbus(uint8_t status, uint8_t data) {
+    if(UART.frame.state==UART_FRAME_IDLE) {
+        UART.frame.state = UART_FRAME_HEADER;
+        UART.frame.crc = 0xFFFF;
+        UART.frame.length = 0;
+    }
+    uint16_t crc = UART.frame.crc;
+    UART.frame.crc = (crc>>8)^UART_CRC16[(uint8_t)crc^data];
+    if(UART.frame.length<UINT8_MAX) {
+        UART.frame.length++;
+    }
+    if(status&(USART_FERR_bm|USART_PERR_bm)) {
+        UART.frame.error = 1;
+        DIGITAL_PrintSymbol((status&USART_FERR_bm) ? FONT_SYMBOL_FERR : FONT_SYMBOL_PERR);
+    } else if(UART.frame.length==1) {
+        DIGITAL_PrintWord(data, 2); // slave ID
+        DIGITAL_PrintChar(':');
+    } else if(UART.frame.length==2) {
+        DIGITAL_PrintWord(data, 2); // function code
+        DIGITAL_PrintTab();
+    } else {
+        DIGITAL_Print(data);
+    }
+}
+
+static inline uint8_t UART_LinParity(uint8_t id) {
+    uint8_t p0 = (id^(id>>1)^(id>>2)^(id>>4))&0x01;
+    uint8_t p1 = (~((id>>1)^(id>>3)^(id>>4)^(id>>5)))&0x01;
+    return id|(p0<<6)|(p1<<7);
+}
+
+/* Break, sync, protected ID, up to 8 data bytes and checksum */
+static void UART_FrameLin(uint8_t status, uint8_t data) {
+    if((status&USART_FERR_bm)&&(data==0)) { // break
+        UART_FrameEnd();
+        UART.frame.state = UART_FRAME_SYNC;
+        UART.frame.error = 0;
+        UART.frame.length = 0;
+        UART.frame.sum = 0;
+        return;
+    }
+    if(status&(USART_FERR_bm|USART_PERR_bm)) {
+        UART.frame.error = 1;
+        DIGITAL_PrintSymbol((status&USART_FERR_bm) ? FONT_SYMBOL_FERR : FONT_SYMBOL_PERR);
+        return;
+    }
+    switch(UART.frame.state) {
+        case UART_FRAME_SYNC:
+            UART.frame.state = UART_FRAME_HEADER;
+            if(data!=UART_LIN_SYNC) {
+                UART.frame.error = 1;
+                DIGITAL_PrintSymbol(FONT_SYMBOL_ERROR);
+            }
+            break;
+        case UART_FRAME_HEADER:
+            UART.frame.state = UART_FRAME_DATA;
+            UART.frame.pid = data;
+            DIGITAL_PrintWord(data&0x3F, 2);
+            if(UART_LinParity(data&0x3F)!=data) {
+                UART.frame.error = 1;
+                DIGITAL_PrintSymbol(FONT_SYMBOL_PERR);
+            } else {
+                DIGITAL_PrintChar(':');
+            }
+            break;
+        case UART_FRAME_DATA: {
+            uint16_t sum = UART.frame.sum+data;
+            UART.frame.sum = sum+(sum>>8); // sum with carry
+            UART.frame.length++;
+            DIGITAL_Print(data);
+            break;
+        }
+        default: // no break received
+            DIGITAL_Print(data);
+            break;
+    }
+}
+
+static void UART_FrameEnd(void) {
+    UART_FRAME_t state = UART.frame.state;
+    UART.frame.state = UART_FRAME_IDLE;
+    if(state==UART_FRAME_IDLE) { return; }
+    uint8_t error = UART.frame.error;
+    UART.frame.error = 0;
+    if(UART.settings.protocol==UART_PROTOCOL_MODBUS) {
+        if((UART.frame.length<4)||UART.frame.crc) { error = 1; }
+    } else if(state!=UART_FRAME_DATA) {
+        error = 1; // header not completed
+    } else if(UART.frame.length) { // frame without response is valid
+        uint8_t classic = UART.frame.sum;
+        uint16_t sum = classic+UART.frame.pid;
+        uint8_t enhanced = sum+(sum>>8);
+        uint8_t id = UART.frame.pid&0x3F;
+        if((id==0x3C)||(id==0x3D)) { enhanced = 0; } // diagnostic frames
+        if(UART.frame.length>9) { error = 1; }
+        if((classic!=0xFF)&&(enhanced!=0xFF)) { error = 1; }
+    }
+    if(error) {
+        DIGITAL_PrintSymbol(FONT_SYMBOL_ERROR);
+    }
+    DIGITAL_EndLine();
 }
 
 static void UART_KeyUp(KEYPAD_KEY_t key) {
@@ -123,28 +425,102 @@ static void UART_KeyUp(KEYPAD_KEY_t key) {
             DISPLAY_Select(-1);
             break;
         case KEYPAD_KEY2:
-            if(DIGITAL_IsHold()) { return; }
+            if(DIGITAL_IsHold()) {
+                UART.view = !UART.view;
+                if(UART.view) {
+                    MAIN_Loop(UART_GapLoop);
+                } else {
+                    DIGITAL_Resume();
+                }
+                return;
+            }
             DIGITAL_EndLine();
             UART.settings.display = !UART.settings.display;
             DIGITAL_Display(UART.settings.display);
             UART_SaveSettings();
             break;
-        case KEYPAD_KEY3: DIGITAL_Hold(!DIGITAL_IsHold()); break;
-        case KEYPAD_KEY4: DIGITAL_Clear(); break;
+        case KEYPAD_KEY3:
+            if(UART.view) {
+                UART.view = 0;
+                DIGITAL_Resume();
+            }
+            DIGITAL_Hold(!DIGITAL_IsHold());
+            break;
+        case KEYPAD_KEY4:
+            for(uint8_t i=0; i<UART_GAPS; i++) {
+                UART.gaps[i].dir = 0;
+            }
+            DIGITAL_Clear();
+            break;
         default: break;
     }
 }
 
+static void UART_GapLog(uint8_t dir, uint16_t time) {
+    if(++UART.last>=UART_GAPS) {
+        UART.last = 0;
+    }
+    UART.gaps[UART.last].dir = dir;
+    UART.gaps[UART.last].time = time;
+}
+
+/* Idle gaps that started the last lines (newest at the bottom), in hold mode */
+static void UART_GapLoop(void) {
+    if(!DISPLAY_Update()) { return; }
+    DISPLAY_CursorPosition(30, 1);
+    puts_P(TEXT_GAPS);
+    DISPLAY_InvertLine(0);
+    uint8_t idx = UART.last;
+    for(uint8_t i=UART_GAPS; i>0; i--) {
+        if(++idx>=UART_GAPS) { idx = 0; }
+        uint8_t dir = UART.gaps[idx].dir;
+        if(!dir) { continue; }
+        uint8_t top = 10+((UART_GAPS-i)*9);
+        uint16_t time = UART.gaps[idx].time;
+        char sign = (dir==USART_TXCIF_bm) ? '<' : '>';
+        DISPLAY_CursorPosition(4, top);
+        if(time==UINT16_MAX) {
+            printf_P(TEXT_GAP_OVER, sign);
+        } else {
+            uint32_t us = (uint32_t)time*2;
+            printf_P(TEXT_GAP_TIME, sign, (uint16_t)(us/1000), (uint16_t)(us%1000));
+        }
+        if(dir==USART_TXCIF_bm) {
+            DISPLAY_InvertLine(top-1);
+        }
+    }
+}
+
 static void UART_SettingsLoop(void) {
     if(!DISPLAY_Update()) { return; }
     DISPLAY_CursorPosition(4, 1);
     puts_P(TEXT_UART_SETTINGS);
     DISPLAY_CursorPosition(4,15);
-    printf_P(TEXT_BAUD, USART_Baud(UART.settings.baud));
+    if(UART.settings.baud==USART_BAUD_AUTO) {
+        puts_P(TEXT_BAUD_AUTO);
+    } else {
+        printf_P(TEXT_BAUD, UART_Baud());
+    }
+    static const __flash char PARITY[] = {
+        [USART_PARITY_NO] = 'N',
+        [USART_PARITY_ODD] = 'O',
+        [USART_PARITY_EVEN] = 'E'
+    };
     DISPLAY_CursorPosition(4,24);
-    printf_P(TEXT_FRAME, USART_Frame(UART.settings.frame));
+    printf_P(TEXT_FRAME_FORMAT, USART_Frame(UART.settings.frame), PARITY[UART.settings.parity]);
     DISPLAY_CursorPosition(4,33);
-    printf_P(TEXT_PARITY, USART_Parity(UART.settings.parity));
+    uint8_t gap = UART_GAP[UART.settings.gap];
+    if(UART.settings.protocol==UART_PROTOCOL_MODBUS) {
+        puts_P(TEXT_MODBUS_RTU);
+    } else if(UART.settings.protocol==UART_PROTOCOL_LIN) {
+        puts_P(TEXT_LIN_BUS);
+    } else if(gap) {
+        printf_P(TEXT_GAP, gap/2, (gap&0x01)*5);
+    } else {
+        puts_P(TEXT_GAP_OFF);
+    }
+    DISPLAY_CursorPosition(4,41);
+    USART_PrintRate(UART.ctrl, UART_Baud());
     DISPLAY_InvertLine(0);
     DISPLAY_SelectLine();
 }
@@ -152,36 +528,326 @@ static void UART_SettingsLoop(void) {
 static void UART_SettingsKeyUp(KEYPAD_KEY_t key) {
     switch(key) {
         case KEYPAD_KEY1:
-            if((UART.settings.baud++)==USART_BAUD_2000000) {
+            if((UART.settings.baud++)==USART_BAUD_AUTO) {
                 UART.settings.baud = USART_BAUD_1200;
             }
+            UART_BaudCtrl();
             DISPLAY_Select(14);
             break;
         case KEYPAD_KEY2:
-            if((UART.settings.frame++)==USART_FRAME_8BIT) {
-                UART.settings.frame = USART_FRAME_5BIT;
+            if((UART.settings.parity++)==USART_PARITY_EVEN) {
+                UART.settings.parity = USART_PARITY_NO;
+                if((UART.settings.frame++)==USART_FRAME_9BIT) {
+                    UART.settings.frame = USART_FRAME_5BIT;
+                }
             }
             DISPLAY_Select(23);
             break;
         case KEYPAD_KEY3:
-            if((UART.settings.parity++)==USART_PARITY_EVEN) {
-                UART.settings.parity = USART_PARITY_NO;
+            /* Gap framing is followed by protocols with own framing */
+            if(UART.settings.protocol) {
+                if((UART.settings.protocol++)==UART_PROTOCOL_LIN) {
+                    UART.settings.protocol = UART_PROTOCOL_RAW;
+                }
+            } else if((++UART.settings.gap)>=sizeof(UART_GAP)) {
+                UART.settings.gap = 0;
+                UART.settings.protocol = UART_PROTOCOL_MODBUS;
             }
+            UART_BaudCtrl();
             DISPLAY_Select(32);
             break;
         case KEYPAD_KEY4:
-            UART_SaveSettings();
-            UART_Setup(&USARTC0);
-            UART_Setup(&USARTD0);
-            KEYPAD_KeyUp(UART_KeyUp);
-            DIGITAL_Init(UART_Decode);
-            DIGITAL_Display(UART.settings.display);
-            DIGITAL_Hold(0);
+            if(UART.settings.baud==USART_BAUD_CUSTOM) {
+                USART_Custom(&UART.settings.custom, UART_SettingsExit);
+            } else {
+                UART_SettingsExit();
+            }
             break;
         default: break;
     }
 }
 
+static void UART_SettingsExit(void) {
+    UART_SaveSettings();
+    UART_BaudCtrl();
+    if(UART.settings.baud==USART_BAUD_AUTO) {
+        UART_AutoStart();
+        return;
+    }
+    UART_Setup(&USARTC0);
+    UART_Setup(&USARTD0);
+    KEYPAD_KeyUp(UART_KeyUp);
+    UART.frame.state = UART_FRAME_IDLE;
+    UART.frame.error = 0;
+    DIGITAL_Init(UART_Decode);
+    DIGITAL_Display(UART.settings.display);
+    DIGITAL_Hold(0);
+}
+
+/* Auto baud timestamps (with EDMA) every edge of the selected RX line with
+ * free running TCC5. TCC5 overflow is captured as well (as a counter value
+ * close to zero), so pulses longer than 2ms are measured correctly.
+ * Minimum pulse width over a window gives the bit period, which is then
+ * refined by averaging whole pulses. Frame length is found by checking
+ * stop bit position after every start bit (line must be idle for at least
+ * UART_AUTO_RUN bits between bursts), parity by checking the bit before
+ * the stop bit. */
+static void UART_AutoStart(void) {
+    uint8_t* detect = (uint8_t*)&UART.detect;
+    for(uint8_t i=0; i<sizeof(UART.detect); i++) {
+        detect[i] = 0;
+    }
+    KEYPAD_KeyUp(UART_AutoKeyUp);
+    MAIN_Loop(UART_AutoLoop);
+    DISPLAY_Select(-1);
+    BUFFER_Stop();
+    BUFFER_Init(BUFFER_MODE_TCC5_CNT);
+    PORTC_PIN6CTRL = PORT_OPC_BUSKEEPER_gc|PORT_ISC_BOTHEDGES_gc; // RX1
+    PORTD_PIN6CTRL = PORT_OPC_BUSKEEPER_gc|PORT_ISC_BOTHEDGES_gc; // RX2
+    EVSYS.CH0MUX = EVSYS_CHMUX_TCC5_OVF_gc; // LUT0 IN1
+    EVSYS.CH2MUX = EVSYS_CHMUX_XCL_LUT0_gc; // Buffer EDMA trigger
+    /* LUT0(EVSYS.CH2) = (EVSYS.CH6) OR (EVSYS.CH0) */
+    XCL.CTRLA = XCL_LUTOUTEN_DISABLE_gc|XCL_PORTSEL_PC_gc|XCL_LUTCONF_2LUT2IN_gc;
+    XCL.CTRLB = XCL_IN3SEL_EVSYS_gc|XCL_IN2SEL_EVSYS_gc|XCL_IN1SEL_EVSYS_gc|XCL_IN0SEL_EVSYS_gc;
+    XCL.CTRLC = XCL_DLY1CONF_NO_gc|XCL_DLY0CONF_NO_gc;
+    XCL.CTRLD = (0x0<<XCL_TRUTH1_gp)|(0xE<<XCL_TRUTH0_gp);
+    /* Timer TCC5 is used to timestamp every RX edge */
+    TCC5.CTRLB = TC45_BYTEM_NORMAL_gc|TC45_WGMODE_NORMAL_gc;
+    TCC5.CTRLA = TC45_CLKSEL_DIV1_gc;
+    UART_AutoInput();
+}
+
+static void UART_AutoInput(void) {
+    if(UART.detect.input) {
+        EVSYS.CH6MUX = EVSYS_CHMUX_PORTD_PIN6_gc; // LUT0 IN0
+    } else {
+        EVSYS.CH6MUX = EVSYS_CHMUX_PORTC_PIN6_gc; // LUT0 IN0
+    }
+    UART.detect.phase = 0;
+    UART.detect.sync = 0;
+    UART.detect.idle = 0;
+    UART.detect.count = 0;
+    UART.detect.ticks = 0;
+    UART.detect.wrapped = 0;
+    UART.detect.min = UINT32_MAX;
+    BUFFER_Clear();
+}
+
+static void UART_AutoLoop(void) {
+    if(BUFFER_Overflow()) {
+        UART_AutoInput();
+    }
+    while(!BUFFER_Empty()) {
+        UART_AutoSample((uint16_t)BUFFER_GetSample());
+    }
+    if(UART.detect.count>=UART_AUTO_BITS) {
+        UART_AutoApply();
+        return;
+    }
+    if(!DISPLAY_Update()) { return; }
+    if(!UART.detect.count&&(++UART.detect.ticks>=UART_AUTO_SWITCH)) {
+        UART.detect.input = !UART.detect.input;
+        UART_AutoInput();
+    }
+    DISPLAY_CursorPosition(15, 1);
+    puts_P(TEXT_AUTO_BAUD);
+    DISPLAY_CursorPosition(4,15);
+    printf_P(TEXT_RX_BITS, UART.detect.input+1, UART.detect.count);
+    DISPLAY_InvertLine(0);
+}
+
+static void UART_AutoKeyUp(KEYPAD_KEY_t key) {
+    switch(key) {
+        case KEYPAD_KEY1:
+            UART.detect.input = !UART.detect.input;
+            UART_AutoInput();
+            break;
+        case KEYPAD_KEY4:
+            if(UART.detect.count) {
+                UART_AutoApply();
+            } else {
+                UART_AutoStop();
+            }
+            break;
+        default: break;
+    }
+}
+
+/* Small counter value is TCC5 overflow, unless the overflow of this period
+ * was already seen and the value is past it (edge just after the overflow),
+ * without edges in between overflows are read at about the same value */
+static void UART_AutoSample(uint16_t sample) {
+    if(sample>=UART_AUTO_MARK) {
+        UART.detect.wrapped = 0;
+    } else if(!UART.detect.wrapped||(sample<=(UART.detect.mark+UART_AUTO_JITTER))) {
+        UART.detect.high++;
+        UART.detect.wrapped = 1;
+        UART.detect.mark = sample;
+        return;
+    }
+    uint32_t time = ((uint32_t)UART.detect.high<<16)|sample;
+    uint32_t pulse = time-UART.detect.last;
+    UART.detect.last = time;
+    if(!UART.detect.sync) {
+        UART.detect.sync = 1;
+        return;
+    }
+    if(pulse<UART_AUTO_GLITCH) {
+        UART.detect.idle = 0; // edges lost, wait for idle line
+        return;
+    }
+    if(UART.detect.phase==0) {
+        if(pulse<UART.detect.min) {
+            UART.detect.min = pulse;
+        }
+        if((++UART.detect.count)>=UART_AUTO_WINDOW) {
+            UART.detect.phase = 1;
+            UART.detect.count = 0;
+        }
+        return;
+    }
+    UART_AutoPulse(pulse);
+}
+
+static void UART_AutoPulse(uint32_t pulse) {
+    const uint32_t min = UART.detect.min;
+    uint8_t level = UART.detect.level;
+    UART.detect.level = !level;
+    if(pulse>(min*UART_AUTO_RUN)) {
+        if(UART.detect.idle) {
+            UART_AutoBits(1, UART_AUTO_RUN);
+        }
+        UART.detect.idle = 1;
+        UART.detect.level = 0; // start bit
+        return;
+    }
+    uint8_t bits = (pulse+(min>>1))/min;
+    UART.detect.sum += pulse;
+    UART.detect.count += bits;
+    if(UART.detect.idle) {
+        UART_AutoBits(level, bits);
+    }
+}
+
+static void UART_AutoBits(uint8_t level, uint8_t bits) {
+    for(uint8_t i=0; i<5; i++) {
+        UART_CHECK_t* check = &UART.detect.check[i];
+        const uint8_t stop = i+6;
+        for(uint8_t n=bits; n>0; n--) {
+            if(check->pos==0) {
+                if(!level) {
+                    check->pos = 1;
+                    check->sum = 0;
+                }
+            } else if(check->pos==stop) {
+                check->frames++;
+                if(!level) { check->errors++; }
+                check->pos = 0;
+            } else {
+                if(check->pos==(stop-1)) {
+                    if(!(check->sum^level)) { check->even++; }
+                } else {
+                    check->sum ^= level;
+                }
+                check->pos++;
+            }
+        }
+    }
+}
+
+static void UART_AutoApply(void) {
+    uint16_t count = UART.detect.count;
+    if(UART.detect.phase&&count) {
+        /* Baud rate with 1/16 bit period resolution */
+        uint32_t period = (UART.detect.sum<<4)/count;
+        uint32_t baud = ((F_CPU<<4)+(period>>1))/period;
+        uint32_t nearest = 0;
+        uint32_t error = UINT32_MAX;
+        for(USART_BAUD_t i=USART_BAUD_1200; i<=USART_BAUD_2000000; i++) {
+            uint32_t standard = USART_Baud(i);
+            uint32_t diff = (baud>standard) ? (baud-standard) : (standard-baud);
+            diff = (diff*1000)/standard;
+            if(diff<error) {
+                error = diff;
+                nearest = standard;
+            }
+        }
+        if(error>UART_AUTO_ERROR) {
+            nearest = baud; // custom baud rate
+        }
+        UART.baud = nearest;
+        UART_BaudCtrl();
+        /* 10-bit frame without any stop bit error, otherwise the shortest
+         * frame without stop bit errors (less than 1/16), shorter frames
+         * also fit data with high bits clear (ASCII) */
+        uint8_t length = UART_AUTO_COMMON;
+        if((UART.detect.check[length].frames<UART_AUTO_FRAMES)||UART.detect.check[length].errors) {
+            for(uint8_t i=0; i<5; i++) {
+                UART_CHECK_t* check = &UART.detect.check[i];
+                if((check->frames>=UART_AUTO_FRAMES)&&((check->errors*16)<=check->frames)) {
+                    length = i;
+                    break;
+                }
+            }
+        }
+        UART_CHECK_t* check = &UART.detect.check[length];
+        uint8_t frame = length+5; // data bits without parity
+        UART.settings.parity = USART_PARITY_NO;
+        if(length&&check->frames) {
+            if((check->even*16)>=(check->frames*15)) {
+                UART.settings.parity = USART_PARITY_EVEN;
+                frame--;
+            } else if((check->even*16)<=check->frames) {
+                UART.settings.parity = USART_PARITY_ODD;
+                frame--;
+            }
+        }
+        if(frame>8) { frame = 8; } // second stop bit
+        UART.settings.frame = frame-5;
+        UART_SaveSettings();
+        int32_t deviation = ((int32_t)(baud-nearest)*1000)/(int32_t)nearest;
+        UART_AutoResult(deviation);
+    }
+    UART_AutoStop();
+}
+
+static void UART_AutoResult(int16_t error) {
+    char sign = '+';
+    if(error<0) {
+        sign = '-';
+        error = -error;
+    }
+    DISPLAY_CursorPosition(15, 1);
+    puts_P(TEXT_AUTO_BAUD);
+    DISPLAY_InvertLine(0);
+    DISPLAY_CursorPosition(4,10);
+    printf_P(TEXT_BAUD, UART.baud);
+    DISPLAY_CursorPosition(4,19);
+    printf_P(TEXT_FRAME, USART_Frame(UART.settings.frame));
+    DISPLAY_CursorPosition(4,28);
+    printf_P(TEXT_PARITY, USART_Parity(UART.settings.parity));
+    DISPLAY_CursorPosition(4,37);
+    printf_P(TEXT_BAUD_ERROR, sign, error/10, error%10);
+    DISPLAY_Send();
+    DELAY_Info();
+}
+
+static void UART_AutoStop(void) {
+    BUFFER_Stop();
+    TCC5.CTRLA = TC45_CLKSEL_OFF_gc;
+    EVSYS.CH0MUX = EVSYS_CHMUX_OFF_gc;
+    EVSYS.CH6MUX = EVSYS_CHMUX_OFF_gc;
+    PORTC_PIN6CTRL = PORT_OPC_BUSKEEPER_gc;
+    PORTD_PIN6CTRL = PORT_OPC_BUSKEEPER_gc;
+    BUFFER_Init(BUFFER_MODE_USART_RX);
+    UART_Setup(&USARTC0);
+    UART_Setup(&USARTD0);
+    KEYPAD_KeyUp(UART_KeyUp);
+    DIGITAL_Init(UART_Decode);
+    DIGITAL_Display(UART.settings.display);
+    DIGITAL_Hold(0);
+}
+
 void UART_Intro(void) {
     DISPLAY_Image(IMAGE_UART);
     DISPLAY_Icons(USART_ICONS);
@@ -189,12 +855,14 @@ void UART_Intro(void) {
 }
 
 void UART_Desc(void) {
-    DISPLAY_CursorPosition(7,7);
+    DISPLAY_CursorPosition(7,5);
     puts_P(TEXT_PARITY_ERR);
-    DISPLAY_CursorPosition(7,16);
+    DISPLAY_CursorPosition(7,14);
     puts_P(TEXT_FRAME_ERR);
-    DISPLAY_CursorPosition(7,25);
+    DISPLAY_CursorPosition(7,23);
     puts_P(TEXT_OVERFLOW);
+    DISPLAY_CursorPosition(7,32);
+    puts_P(TEXT_BREAK);
     DISPLAY_Icons(USART_ICONS);
     DISPLAY_Send();
     DELAY_Info();
@@ -206,10 +874,10 @@ static inline void UART_SaveSettings(void) {
 
 static inline void UART_LoadSettings(void) {
     eeprom_read_block(&UART.settings, &UART_settings, sizeof(UART_SETTINGS_t));
-    if(UART.settings.baud>USART_BAUD_2000000) {
+    if(UART.settings.baud>USART_BAUD_AUTO) {
         UART.settings.baud = USART_BAUD_9600;
     }
-    if(UART.settings.frame>USART_FRAME_8BIT) {
+    if(UART.settings.frame>USART_FRAME_9BIT) {
         UART.settings.frame = USART_FRAME_8BIT;
     }
     if(UART.settings.parity>USART_PARITY_EVEN) {
@@ -218,5 +886,17 @@ static inline void UART_LoadSettings(void) {
     if(UART.settings.display>DIGITAL_DISPLAY_ASCII) {
         UART.settings.display = DIGITAL_DISPLAY_HEX;
     }
+    uint32_t custom = UART.settings.custom;
+    if((custom<USART_CUSTOM_MIN)||(custom>USART_CUSTOM_MAX)) {
+        UART.settings.custom = USART_CUSTOM_DEF;
+    }
+    if(UART.settings.gap>=sizeof(UART_GAP)) {
+        UART.settings.gap = 0;
+    }
+    if(UART.settings.protocol>UART_PROTOCOL_LIN) {
+        UART.settings.protocol = UART_PROTOCOL_RAW;
+    }
     UART_SaveSettings();
+    UART.baud = USART_Baud(USART_BAUD_9600);
+    UART_BaudCtrl();
 }
@@ -21,8 +21,20 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "delay.h"
 #include "font.h"
 #include "icon.h"
+#include "main.h"
+#include "keypad.h"
 #include "usart.h"
 
+static struct {
+    uint32_t* baud;
+    uint32_t step;
+    uint16_t ctrl;
+    USART_Callback_t Exit;
+} USART;
+
+static void USART_CustomLoop(void);
+static void USART_CustomKeyUp(KEYPAD_KEY_t key);
+
 void USART_Info(void) {
     DISPLAY_CursorPosition(11, 1);
     DISPLAY_Icon(ICON_SETTINGS);
@@ -73,7 +85,8 @@ uint8_t USART_Frame(USART_FRAME_t frame) {
         [USART_FRAME_5BIT] = 5,
         [USART_FRAME_6BIT] = 6,
         [USART_FRAME_7BIT] = 7,
-        [USART_FRAME_8BIT] = 8
+        [USART_FRAME_8BIT] = 8,
+        [USART_FRAME_9BIT] = 9
     };
     return FRAME[frame];
 }
@@ -92,7 +105,8 @@ USART_CHSIZE_t USART_CHSIZE(USART_FRAME_t frame) {
         [USART_FRAME_5BIT] = USART_CHSIZE_5BIT_gc,
         [USART_FRAME_6BIT] = USART_CHSIZE_6BIT_gc,
         [USART_FRAME_7BIT] = USART_CHSIZE_7BIT_gc,
-        [USART_FRAME_8BIT] = USART_CHSIZE_8BIT_gc
+        [USART_FRAME_8BIT] = USART_CHSIZE_8BIT_gc,
+        [USART_FRAME_9BIT] = USART_CHSIZE_9BIT_gc
     };
     return CHSIZE[frame];
 }
@@ -106,7 +120,9 @@ USART_PMODE_t USART_PMODE(USART_PARITY_t parity) {
     return PMODE[parity];
 }
 
-void USART_SetBaudAsync(USART_t* const usart, uint32_t baud) {
+/* Returns BAUDCTRLB:BAUDCTRLA for normal speed (CLK2X off), so it could be
+ * computed once and written with USART_SetBaudCtrl when needed. */
+uint16_t USART_BaudAsync(uint32_t baud) {
     int8_t exp;
     uint32_t div;
     uint32_t limit;
@@ -121,17 +137,16 @@ void USART_SetBaudAsync(USART_t* const usart, uint32_t baud) {
     max_rate = cpu_hz / 8;
     /* 4194304 = (2^7) * 8 * (2^12) = (2^BSCALE_MAX) * 8 * (BSEL_MAX+1) */
     min_rate = cpu_hz / 4194304;
-    if (!((usart)->CTRLB & USART_CLK2X_bm)) {
-        max_rate /= 2;
-        min_rate /= 2;
-    }
-    if ((baud > max_rate) || (baud < min_rate)) {
-        return;
+    max_rate /= 2;
+    min_rate /= 2;
+    if (baud > max_rate) {
+        baud = max_rate;
     }
-    /* Check if double speed is enabled. */
-    if (!((usart)->CTRLB & USART_CLK2X_bm)) {
-        baud *= 2;
+    if (baud < min_rate) {
+        baud = min_rate;
     }
+    /* Normal speed */
+    baud *= 2;
     /* Find the lowest possible exponent. */
     limit = 0xfffU >> 4;
     ratio = cpu_hz / baud;
@@ -180,8 +195,87 @@ void USART_SetBaudAsync(USART_t* const usart, uint32_t baud) {
         baud <<= exp + 3;
         div = (cpu_hz + baud / 2) / baud - 1;
     }
-    (usart)->BAUDCTRLB = (uint8_t)(((div >> 8) & 0X0F) | (exp << 4));
-    (usart)->BAUDCTRLA = (uint8_t)div;
+    return ((uint16_t)(uint8_t)(((div >> 8) & 0X0F) | (exp << 4))<<8)|(uint8_t)div;
+}
+
+/* Baud rate actually achieved with given BAUDCTRLB:BAUDCTRLA (CLK2X off) */
+uint32_t USART_BaudRate(uint16_t ctrl) {
+    uint16_t bsel = ctrl&0x0FFF;
+    int8_t bscale = ((int8_t)(ctrl>>8))>>4;
+    if(bscale<0) {
+        uint8_t shift = -bscale;
+        uint32_t div = 16UL*(((uint32_t)bsel)+(1<<shift));
+        return ((F_CPU<<shift)+(div>>1))/div;
+    }
+    uint32_t div = (16UL<<bscale)*(bsel+1);
+    return (F_CPU+(div>>1))/div;
+}
+
+void USART_PrintRate(uint16_t ctrl, uint32_t baud) {
+    uint32_t rate = USART_BaudRate(ctrl);
+    int32_t error = ((int32_t)(rate-baud)*1000)/(int32_t)baud;
+    char sign = '+';
+    if(error<0) {
+        sign = '-';
+        error = -error;
+    }
+    printf_P(TEXT_BAUD_RATE, rate, sign, (uint16_t)(error/10), (uint16_t)(error%10));
+}
+
+void USART_Custom(uint32_t* baud, USART_Callback_t Exit) {
+    USART.baud = baud;
+    USART.step = 1000;
+    USART.ctrl = USART_BaudAsync(*baud);
+    USART.Exit = Exit;
+    KEYPAD_KeyUp(USART_CustomKeyUp);
+    MAIN_Loop(USART_CustomLoop);
+    DISPLAY_Select(14);
+}
+
+static void USART_CustomLoop(void) {
+    if(!DISPLAY_Update()) { return; }
+    DISPLAY_CursorPosition(9, 1);
+    puts_P(TEXT_CUSTOM_BAUD);
+    DISPLAY_CursorPosition(4,15);
+    printf_P(TEXT_BAUD, *USART.baud);
+    DISPLAY_CursorPosition(4,24);
+    printf_P(TEXT_STEP, USART.step);
+    DISPLAY_CursorPosition(4,33);
+    USART_PrintRate(USART.ctrl, *USART.baud);
+    DISPLAY_InvertLine(0);
+    DISPLAY_SelectLine();
+}
+
+static void USART_CustomKeyUp(KEYPAD_KEY_t key) {
+    uint32_t baud = *USART.baud;
+    switch(key) {
+        case KEYPAD_KEY1:
+            USART.step *= 10;
+            if(USART.step>1000000) {
+                USART.step = 1;
+            }
+            break;
+        case KEYPAD_KEY2:
+            if(baud>(USART_CUSTOM_MIN+USART.step)) {
+                baud -= USART.step;
+            } else {
+                baud = USART_CUSTOM_MIN;
+            }
+            break;
+        case KEYPAD_KEY3:
+            if(baud<(USART_CUSTOM_MAX-USART.step)) {
+                baud += USART.step;
+            } else {
+                baud = USART_CUSTOM_MAX;
+            }
+            break;
+        case KEYPAD_KEY4:
+            USART.Exit();
+            return;
+        default: break;
+    }
+    *USART.baud = baud;
+    USART.ctrl = USART_BaudAsync(baud);
 }
 
 const __flash uint8_t* const __flash USART_ICONS[] = {
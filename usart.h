@@ -16,6 +16,10 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #ifndef USART_H_INCLUDED
 #define USART_H_INCLUDED
 
+#define USART_CUSTOM_MIN      300
+#define USART_CUSTOM_DEF   250000
+#define USART_CUSTOM_MAX  2000000
+
 typedef enum {
     USART_BAUD_1200,
     USART_BAUD_2400,
@@ -33,14 +37,17 @@ typedef enum {
     USART_BAUD_921600,
     USART_BAUD_1382000,
     USART_BAUD_1843000,
-    USART_BAUD_2000000
+    USART_BAUD_2000000,
+    USART_BAUD_CUSTOM,
+    USART_BAUD_AUTO
 } USART_BAUD_t;
 
 typedef enum {
     USART_FRAME_5BIT,
     USART_FRAME_6BIT,
     USART_FRAME_7BIT,
-    USART_FRAME_8BIT
+    USART_FRAME_8BIT,
+    USART_FRAME_9BIT
 } USART_FRAME_t;
 
 typedef enum {
@@ -49,13 +56,23 @@ typedef enum {
     USART_PARITY_EVEN
 } USART_PARITY_t;
 
+typedef void (*USART_Callback_t)(void);
+
 void USART_Info(void);
 uint32_t USART_Baud(USART_BAUD_t baud);
 uint8_t USART_Frame(USART_FRAME_t frame);
 const __flash char* USART_Parity(USART_PARITY_t parity);
 USART_CHSIZE_t USART_CHSIZE(USART_FRAME_t frame);
 USART_PMODE_t USART_PMODE(USART_PARITY_t parity);
-void USART_SetBaudAsync(USART_t* const usart, uint32_t baud);
+uint16_t USART_BaudAsync(uint32_t baud);
+uint32_t USART_BaudRate(uint16_t ctrl);
+void USART_PrintRate(uint16_t ctrl, uint32_t baud);
+void USART_Custom(uint32_t* baud, USART_Callback_t Exit);
+
+static inline void USART_SetBaudCtrl(USART_t* const usart, uint16_t ctrl) {
+    (usart)->BAUDCTRLB = (uint8_t)(ctrl>>8);
+    (usart)->BAUDCTRLA = (uint8_t)(ctrl);
+}
 
 inline void USART_SetBaudSync(USART_t* const usart, uint32_t baud) {
     uint16_t bsel = 0;
@@ -44,8 +44,7 @@ static void VOLTAGE_Result(int16_t value) {
 static void VOLTAGE_Setup(void) {
     ADCA.CH0.CTRL = ADC_CH_GAIN_DIV2_gc|ADC_CH_INPUTMODE_DIFFWGAINH_gc;
     ADCA.CH0.MUXCTRL = ADC_CH_MUXPOS_PIN8_gc|ADC_CH_MUXNEGH_PIN5_gc;
-    ADCA.CH0.AVGCTRL = (1<<ADC_CH_RIGHTSHIFT_gp)|ADC_SAMPNUM_8X_gc; // 14-bit mode (signed)
-    ANALOG_Init(&VOLTAGE_settings);
+    ANALOG_Init(&VOLTAGE_settings, 14); // 14-bit mode (signed)
     ANALOG_Result(VOLTAGE_Result);
 }
 
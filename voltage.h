@@ -16,6 +16,10 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #ifndef VOLTAGE_H_INCLUDED
 #define VOLTAGE_H_INCLUDED
 
+#include "analog.h"
+
+extern ANALOG_SETTINGS_t VOLTAGE_settings;
+
 void VOLTAGE_Init(void);
 void VOLTAGE_Intro(void);
 void VOLTAGE_Calibration(void);